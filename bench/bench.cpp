@@ -0,0 +1,501 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+// Measures the throughput, the memory allocations and the peak memory
+// of unserialize(), and of copying and comparing the resulting values,
+// on a generated corpus. The corpus is the same on every run and every
+// platform.
+//
+// Usage: pherialize-bench [min-seconds-per-measure]
+//
+// Build with CMAKE_BUILD_TYPE=Release for meaningful figures.
+
+#include "pherialize/unserialize.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+#	define PHERIALIZE_BENCH_HAVE_RUSAGE 1
+#	include <sys/resource.h>
+#endif
+
+#if defined(__GLIBC__)
+#	include <malloc.h>
+#endif
+
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+
+
+using namespace pherialize;
+
+
+// Allocation counting: every allocation made by the library (which is
+// linked dynamically) goes through these operators
+
+static std::atomic <std::size_t> allocationCount(0);
+
+
+void *operator new(std::size_t size) {
+
+	++allocationCount;
+
+	if (void *p = std::malloc(size != 0 ? size : 1)) {
+		return p;
+	}
+
+	throw std::bad_alloc();
+}
+
+
+void *operator new[](std::size_t size) {
+
+	return operator new(size);
+}
+
+
+void operator delete(void *p) noexcept {
+
+	std::free(p);
+}
+
+
+void operator delete[](void *p) noexcept {
+
+	std::free(p);
+}
+
+
+
+/** Writes serialized data, with values drawn from a fixed-seed
+  * generator. std::mt19937 is fully specified by the standard (unlike
+  * the distributions), so the output is the same everywhere.
+  */
+class CorpusWriter {
+
+public:
+
+	CorpusWriter() : m_random(20130601) { }
+
+	std::size_t random(const std::size_t n) {
+		return m_random() % n;
+	}
+
+	void writeInt(const long long value) {
+		m_data += "i:" + boost::lexical_cast <std::string>(value) + ";";
+	}
+
+	void writeBool(const bool value) {
+		m_data += value ? "b:1;" : "b:0;";
+	}
+
+	void writeDouble(const double value) {
+		m_data += (boost::format("d:%.17g;") % value).str();
+	}
+
+	void writeNull() {
+		m_data += "N;";
+	}
+
+	void writeString(const std::string &value) {
+		m_data += "s:" + boost::lexical_cast <std::string>(value.length()) + ":\"" + value + "\";";
+	}
+
+	void writeRandomString(const std::size_t length) {
+
+		static const char CHARS[] = "abcdefghijklmnopqrstuvwxyz0123456789 _-/:;\"{}";
+
+		std::string str(length, ' ');
+
+		for (std::size_t i = 0 ; i < length ; ++i) {
+			str[i] = CHARS[random(sizeof(CHARS) - 1)];
+		}
+
+		writeString(str);
+	}
+
+	void writeArrayBegin(const std::size_t count) {
+		m_data += "a:" + boost::lexical_cast <std::string>(count) + ":{";
+	}
+
+	void writeObjectBegin(const std::string &className, const std::size_t count) {
+
+		m_data += "O:" + boost::lexical_cast <std::string>(className.length())
+			+ ":\"" + className + "\":" + boost::lexical_cast <std::string>(count) + ":{";
+	}
+
+	void writeArrayEnd() {
+		m_data += "}";
+	}
+
+	std::string &data() {
+		return m_data;
+	}
+
+private:
+
+	std::mt19937 m_random;
+	std::string m_data;
+};
+
+
+// PHP sessions: maps of short string keys to scalars and small arrays
+static std::string sessionMaps() {
+
+	CorpusWriter w;
+
+	w.writeArrayBegin(2000);
+
+	for (int i = 0 ; i < 2000 ; ++i) {
+
+		w.writeString("sess_" + boost::lexical_cast <std::string>(i));
+		w.writeArrayBegin(8);
+
+		w.writeString("user_id"); w.writeInt(w.random(1000000));
+		w.writeString("login"); w.writeRandomString(6 + w.random(10));
+		w.writeString("logged_in"); w.writeBool(w.random(2) != 0);
+		w.writeString("last_seen"); w.writeInt(1370000000 + w.random(10000000));
+		w.writeString("locale"); w.writeString(w.random(2) ? "en_US" : "fr_FR");
+		w.writeString("cart_total"); w.writeDouble(w.random(100000) / 100.0);
+		w.writeString("flash"); w.writeNull();
+		w.writeString("roles");
+
+		const std::size_t roles = 1 + w.random(4);
+
+		w.writeArrayBegin(roles);
+
+		for (std::size_t j = 0 ; j < roles ; ++j) {
+			w.writeInt(j);
+			w.writeRandomString(4 + w.random(6));
+		}
+
+		w.writeArrayEnd();
+		w.writeArrayEnd();
+	}
+
+	w.writeArrayEnd();
+
+	return w.data();
+}
+
+
+static void writeNested(CorpusWriter &w, const int depth) {
+
+	if (depth == 0) {
+		w.writeInt(w.random(100));
+		return;
+	}
+
+	w.writeArrayBegin(3);
+
+	for (int i = 0 ; i < 3 ; ++i) {
+		w.writeInt(i);
+		writeNested(w, depth - 1);
+	}
+
+	w.writeArrayEnd();
+}
+
+
+// Deeply nested arrays: few scalars, many small arrays
+static std::string nestedArrays() {
+
+	CorpusWriter w;
+
+	w.writeArrayBegin(20);
+
+	for (int i = 0 ; i < 20 ; ++i) {
+		w.writeInt(i);
+		writeNested(w, 8);
+	}
+
+	w.writeArrayEnd();
+
+	return w.data();
+}
+
+
+// Large string payloads (cached pages, blobs)
+static std::string largeStrings() {
+
+	CorpusWriter w;
+
+	w.writeArrayBegin(64);
+
+	for (int i = 0 ; i < 64 ; ++i) {
+		w.writeString("page_" + boost::lexical_cast <std::string>(i));
+		w.writeRandomString(16384 + w.random(65536));
+	}
+
+	w.writeArrayEnd();
+
+	return w.data();
+}
+
+
+// Numeric arrays (statistics, coordinates)
+static std::string numericArrays() {
+
+	CorpusWriter w;
+
+	w.writeArrayBegin(100);
+
+	for (int i = 0 ; i < 100 ; ++i) {
+
+		w.writeInt(i);
+		w.writeArrayBegin(1000);
+
+		for (int j = 0 ; j < 1000 ; ++j) {
+
+			w.writeInt(j);
+
+			if (j % 2) {
+				w.writeDouble((static_cast <double>(w.random(2000000)) - 1000000) / 997);
+			} else {
+				w.writeInt(static_cast <long long>(w.random(4000000000u)) - 2000000000);
+			}
+		}
+
+		w.writeArrayEnd();
+	}
+
+	w.writeArrayEnd();
+
+	return w.data();
+}
+
+
+// Objects ("O:" values), as written for PHP class instances
+static std::string objects() {
+
+	CorpusWriter w;
+
+	w.writeArrayBegin(5000);
+
+	for (int i = 0 ; i < 5000 ; ++i) {
+
+		w.writeInt(i);
+		w.writeObjectBegin("App\\Model\\Product", 5);
+
+		w.writeString("id"); w.writeInt(i);
+		w.writeString(std::string("\0*\0name", 7)); w.writeRandomString(10 + w.random(30));
+		w.writeString("price"); w.writeDouble(w.random(100000) / 100.0);
+		w.writeString("available"); w.writeBool(w.random(4) != 0);
+		w.writeString("tags");
+
+		w.writeArrayBegin(2);
+		w.writeInt(0); w.writeRandomString(5);
+		w.writeInt(1); w.writeRandomString(7);
+		w.writeArrayEnd();
+
+		w.writeArrayEnd();
+	}
+
+	w.writeArrayEnd();
+
+	return w.data();
+}
+
+
+
+// Number of values in a tree, keys included
+static std::size_t countNodes(const Mixed &value) {
+
+	if (value.type() != Mixed::TYPE_ARRAY) {
+		return 1;
+	}
+
+	const MixedArray &array = value.arrayValue();
+	std::size_t count = 1;
+
+	if (array.type() == MixedArray::TYPE_VECTOR) {
+
+		const std::vector <Mixed> &vector = array.vectorValue();
+
+		for (std::size_t i = 0 ; i < vector.size() ; ++i) {
+			count += 1 + countNodes(vector[i]);
+		}
+
+	} else if (array.type() == MixedArray::TYPE_MAP) {
+
+		const std::vector <MixedArray::Entry> &entries = array.entries();
+
+		for (std::size_t i = 0 ; i < entries.size() ; ++i) {
+			count += countNodes(entries[i].first) + countNodes(entries[i].second);
+		}
+	}
+
+	return count;
+}
+
+
+typedef std::chrono::steady_clock Clock;
+
+
+/** Resets the peak resident set size of the process to its current
+  * size, where supported (Linux >= 4.0), so that the peak of each
+  * operation is measured. Elsewhere, the peak of the process so far
+  * is reported.
+  */
+static void resetPeakMemory() {
+
+#if defined(__linux__)
+
+#	if defined(__GLIBC__)
+	// Give memory freed by previous operations back to the system
+	malloc_trim(0);
+#	endif
+
+	std::ofstream("/proc/self/clear_refs") << "5";
+
+#endif
+}
+
+
+/** Returns the peak resident set size, in megabytes, or a negative
+  * value if it is not available on this platform.
+  */
+static double peakMemory() {
+
+#if defined(__linux__)
+
+	std::ifstream status("/proc/self/status");
+	std::string line;
+
+	while (std::getline(status, line)) {
+
+		// "VmHWM:    1234 kB"
+		if (line.compare(0, 6, "VmHWM:") == 0) {
+			return std::strtod(line.c_str() + 6, NULL) / 1024;
+		}
+	}
+
+#endif
+
+#if PHERIALIZE_BENCH_HAVE_RUSAGE
+
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+
+#	if defined(__APPLE__)
+		return usage.ru_maxrss / (1024.0 * 1024);  // bytes
+#	else
+		return usage.ru_maxrss / 1024.0;  // kilobytes
+#	endif
+	}
+
+#endif
+
+	return -1;
+}
+
+
+/** Runs an operation repeatedly for at least the given time, and
+  * prints its throughput, the number of allocations it makes and
+  * the peak memory used while it runs.
+  */
+template <typename F>
+static void measure(const char *operation, const std::size_t bytes, const std::size_t nodes,
+                    const double minSeconds, F f) {
+
+	resetPeakMemory();
+
+	// First run: allocations
+	const std::size_t allocationsBefore = allocationCount;
+	f();
+	const std::size_t allocations = allocationCount - allocationsBefore;
+
+	std::size_t iterations = 0;
+	double seconds = 0;
+
+	const Clock::time_point start = Clock::now();
+
+	do {
+
+		f();
+
+		++iterations;
+		seconds = std::chrono::duration <double>(Clock::now() - start).count();
+
+	} while (seconds < minSeconds);
+
+	const double perSecond = iterations / seconds;
+	const double peak = peakMemory();
+
+	std::cout << boost::format("  %-12s %10.1f MB/s %12.0f nodes/s %8.3f allocs/node %10s peak\n")
+		% operation
+		% (bytes * perSecond / (1024 * 1024))
+		% (nodes * perSecond)
+		% (static_cast <double>(allocations) / nodes)
+		% (peak < 0 ? std::string("n/a") : (boost::format("%.1f MB") % peak).str());
+}
+
+
+int main(int argc, char **argv) {
+
+	const double minSeconds = (argc > 1) ? boost::lexical_cast <double>(argv[1]) : 1.0;
+
+	struct Corpus {
+		const char *name;
+		std::string (*generate)();
+	};
+
+	const Corpus corpora[] = {
+		{ "session maps", sessionMaps },
+		{ "nested arrays", nestedArrays },
+		{ "large strings", largeStrings },
+		{ "numeric arrays", numericArrays },
+		{ "objects", objects }
+	};
+
+	for (std::size_t i = 0 ; i < sizeof(corpora) / sizeof(corpora[0]) ; ++i) {
+
+		const std::string data = corpora[i].generate();
+		const shared_ptr <Mixed> value = unserialize(data);
+		const std::size_t nodes = countNodes(*value);
+
+		std::cout << boost::format("%s: %d bytes, %d nodes\n") % corpora[i].name % data.length() % nodes;
+
+		measure("unserialize", data.length(), nodes, minSeconds, [&data]() {
+			unserialize(data);
+		});
+
+		measure("copy", data.length(), nodes, minSeconds, [&value]() {
+			Mixed copy(*value);
+		});
+
+		const Mixed copy(*value);
+
+		measure("compare", data.length(), nodes, minSeconds, [&value, &copy]() {
+			if (!(*value == copy)) {
+				std::abort();
+			}
+		});
+	}
+
+	return 0;
+}
@@ -0,0 +1,120 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "pherialize/Arena.hpp"
+
+#include <cstdlib>
+#include <new>
+
+
+
+namespace pherialize {
+
+
+// Blocks never grow beyond this size, unless a single
+// allocation requires it
+static const std::size_t MAX_BLOCK_SIZE = 1024 * 1024;
+
+
+Arena::Arena(const std::size_t blockSize) {
+
+	m_block = NULL;
+	m_current = NULL;
+	m_end = NULL;
+	m_nextBlockSize = blockSize ? blockSize : 1;
+	m_capacity = 0;
+}
+
+
+Arena::~Arena() {
+
+	clear();
+}
+
+
+void *Arena::allocate(const std::size_t size, const std::size_t alignment) {
+
+	const std::size_t misalignment = reinterpret_cast <std::size_t>(m_current) & (alignment - 1);
+	const std::size_t padding = misalignment ? alignment - misalignment : 0;
+
+	if (m_current != NULL && padding + size <= static_cast <std::size_t>(m_end - m_current)) {
+
+		void *ptr = m_current + padding;
+		m_current += padding + size;
+
+		return ptr;
+	}
+
+	return allocateBlock(size, alignment);
+}
+
+
+void *Arena::allocateBlock(const std::size_t size, const std::size_t alignment) {
+
+	// Block header is followed by data, aligned on the header size
+	const std::size_t headerSize = sizeof(Block) + (alignment > sizeof(Block) ? alignment : 0);
+
+	std::size_t blockSize = m_nextBlockSize;
+
+	while (blockSize < size + headerSize) {
+		blockSize *= 2;
+	}
+
+	Block *block = static_cast <Block *>(std::malloc(blockSize));
+
+	if (block == NULL) {
+		throw std::bad_alloc();
+	}
+
+	block->previous = m_block;
+	block->size = blockSize;
+
+	m_block = block;
+	m_current = reinterpret_cast <char *>(block) + sizeof(Block);
+	m_end = reinterpret_cast <char *>(block) + blockSize;
+	m_capacity += blockSize;
+
+	if (m_nextBlockSize < MAX_BLOCK_SIZE) {
+		m_nextBlockSize *= 2;
+	}
+
+	return allocate(size, alignment);
+}
+
+
+void Arena::clear() {
+
+	while (m_block != NULL) {
+
+		Block *previous = m_block->previous;
+		std::free(m_block);
+		m_block = previous;
+	}
+
+	m_current = NULL;
+	m_end = NULL;
+	m_capacity = 0;
+}
+
+
+std::size_t Arena::capacity() const {
+	return m_capacity;
+}
+
+
+} // namespace pherialize
@@ -0,0 +1,104 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_ARENA_HPP_INCLUDED
+#define PHERIALIZE_ARENA_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+#include "pherialize/export.hpp"
+
+#include <cstddef>
+
+
+namespace pherialize {
+
+
+/** A bump allocator. Memory is carved sequentially out of large
+  * blocks and is only released all at once, when the arena is
+  * cleared or destroyed. No destructor is run on objects
+  * allocated from the arena.
+  */
+class PHERIALIZE_EXPORT Arena {
+
+public:
+
+	/** Constructs a new, empty arena.
+	  *
+	  * @param blockSize size of the first block to allocate, in bytes;
+	  * subsequent blocks grow geometrically
+	  */
+	Arena(const std::size_t blockSize = 4096);
+
+	~Arena();
+
+	/** Allocates uninitialized memory from the arena.
+	  *
+	  * @param size number of bytes to allocate
+	  * @param alignment required alignment (must be a power of 2)
+	  * @return pointer to allocated memory, valid until the arena
+	  * is cleared or destroyed
+	  */
+	void *allocate(const std::size_t size, const std::size_t alignment = sizeof(void *));
+
+	/** Allocates an uninitialized array of objects from the arena.
+	  *
+	  * @param count number of objects
+	  * @return pointer to the first object
+	  */
+	template <typename T>
+	T *allocateArray(const std::size_t count) {
+		return static_cast <T *>(allocate(count * sizeof(T), alignof(T)));
+	}
+
+	/** Releases all the memory allocated from this arena.
+	  */
+	void clear();
+
+	/** Returns the total size of the blocks held by this arena.
+	  *
+	  * @return size in bytes
+	  */
+	std::size_t capacity() const;
+
+private:
+
+	Arena(const Arena &);
+	Arena &operator=(const Arena &);
+
+
+	struct Block {
+		Block *previous;
+		std::size_t size;
+	};
+
+	void *allocateBlock(const std::size_t size, const std::size_t alignment);
+
+
+	Block *m_block;
+	char *m_current;
+	char *m_end;
+	std::size_t m_nextBlockSize;
+	std::size_t m_capacity;
+};
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_ARENA_HPP_INCLUDED
@@ -0,0 +1,487 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "pherialize/BatchUnserializer.hpp"
+#include "pherialize/unserialize.hpp"
+#include "pherialize/validate.hpp"
+#include "pherialize/Tokenizer.hpp"
+
+#include <stdexcept>
+#include <exception>
+#include <algorithm>
+#include <utility>
+
+
+
+namespace pherialize {
+
+
+// Arrays with fewer elements are not worth splitting
+static const std::size_t MIN_PARALLEL_ELEMENTS = 1024;
+
+// Number of ranges of elements per thread, so that a thread which
+// gets the larger elements does not delay the others
+static const std::size_t RANGES_PER_THREAD = 16;
+
+// No depth limit is enforced by unserialize(); deeper data is only
+// unserialized sequentially
+static const std::size_t MAX_SCAN_DEPTH = 4096;
+
+
+
+// Unserializes each input of a batch
+class BatchUnserializer::BatchJob : public BatchUnserializer::Job {
+
+public:
+
+	BatchJob(const BatchInput *inputs, BatchResult *results)
+		: m_inputs(inputs), m_results(results) {
+
+	}
+
+	void run(const std::size_t task) {
+
+		const BatchInput &input = m_inputs[task];
+		BatchResult &result = m_results[task];
+
+		try {
+
+			result.value = unserialize(input.data, input.length);
+			result.ok = true;
+
+		} catch (std::exception &e) {
+
+			result.ok = false;
+			result.error = e.what();
+		}
+	}
+
+private:
+
+	const BatchInput *m_inputs;
+	BatchResult *m_results;
+};
+
+
+
+// Unserializes ranges of the elements of an array; offsets[i] is the
+// position of the key of the i-th element, and offsets[count] the
+// position of the closing brace
+class BatchUnserializer::ArrayJob : public BatchUnserializer::Job {
+
+public:
+
+	ArrayJob(const char *data, const std::vector <std::size_t> &offsets,
+	         const std::size_t rangeCount, std::vector <MixedArray::Entry> &entries)
+		: m_data(data), m_offsets(offsets), m_rangeCount(rangeCount),
+		  m_entries(entries), m_errors(rangeCount) {
+
+	}
+
+	void run(const std::size_t task) {
+
+		const std::size_t count = m_entries.size();
+		const std::size_t first = count * task / m_rangeCount;
+		const std::size_t last = count * (task + 1) / m_rangeCount;
+
+		try {
+
+			Unserializer un(m_data + m_offsets[first], m_offsets[last] - m_offsets[first]);
+
+			for (std::size_t i = first ; i < last ; ++i) {
+				m_entries[i].first = un.unserializeValue();
+				m_entries[i].second = un.unserializeValue();
+			}
+
+		} catch (...) {
+
+			m_errors[task] = std::current_exception();
+		}
+	}
+
+	void rethrowError() const {
+
+		// Report the error of the first range, as a sequential
+		// unserialization would
+		for (std::size_t i = 0 ; i < m_errors.size() ; ++i) {
+
+			if (m_errors[i]) {
+				std::rethrow_exception(m_errors[i]);
+			}
+		}
+	}
+
+private:
+
+	const char *m_data;
+	const std::vector <std::size_t> &m_offsets;
+	const std::size_t m_rangeCount;
+
+	std::vector <MixedArray::Entry> &m_entries;
+	std::vector <std::exception_ptr> m_errors;
+};
+
+
+
+BatchUnserializer::BatchUnserializer(const std::size_t threadCount)
+	: m_queues(threadCount != 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency())) {
+
+	m_generation = 0;
+	m_busyThreads = 0;
+	m_active = false;
+	m_stopping = false;
+
+	m_job = NULL;
+
+	// The calling thread is worker 0
+	try {
+
+		for (std::size_t i = 1 ; i < m_queues.size() ; ++i) {
+			m_threads.push_back(std::thread(&BatchUnserializer::threadMain, this, i));
+		}
+
+	} catch (...) {
+
+		{
+			std::lock_guard <std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+
+		m_workAvailable.notify_all();
+
+		for (std::size_t i = 0 ; i < m_threads.size() ; ++i) {
+			m_threads[i].join();
+		}
+
+		throw;
+	}
+}
+
+
+BatchUnserializer::~BatchUnserializer() {
+
+	{
+		std::lock_guard <std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+
+	m_workAvailable.notify_all();
+
+	for (std::size_t i = 0 ; i < m_threads.size() ; ++i) {
+		m_threads[i].join();
+	}
+}
+
+
+std::size_t BatchUnserializer::threadCount() const {
+
+	return m_queues.size();
+}
+
+
+std::vector <BatchResult> BatchUnserializer::unserializeBatch(const std::vector <std::string> &inputs) {
+
+	std::vector <BatchInput> batch(inputs.size());
+
+	for (std::size_t i = 0 ; i < inputs.size() ; ++i) {
+		batch[i].data = inputs[i].data();
+		batch[i].length = inputs[i].length();
+	}
+
+	return unserializeBatch(batch.data(), batch.size());
+}
+
+
+std::vector <BatchResult> BatchUnserializer::unserializeBatch(const BatchInput *inputs, const std::size_t count) {
+
+	std::vector <BatchResult> results(count);
+
+	BatchJob job(inputs, results.data());
+	runJob(job, count);
+
+	return results;
+}
+
+
+shared_ptr <Mixed> BatchUnserializer::unserializeParallel(const std::string &str) {
+
+	return unserializeParallel(str.data(), str.length());
+}
+
+
+shared_ptr <Mixed> BatchUnserializer::unserializeParallel(const char *data, const std::size_t length) {
+
+	if (m_queues.size() == 1) {
+		return unserialize(data, length);
+	}
+
+	// Array header
+	Tokenizer tokenizer(data, length);
+	std::size_t count;
+
+	try {
+
+		switch (tokenizer.readType()) {
+
+			case 'a':
+
+				count = tokenizer.readArrayBegin();
+				break;
+
+			case 'O': {
+
+				const char *className;
+				std::size_t classNameLength;
+
+				count = tokenizer.readObjectBegin(className, classNameLength);
+				break;
+			}
+			default:
+
+				count = 0;
+				break;
+		}
+
+	} catch (std::runtime_error &) {
+
+		count = 0;
+	}
+
+	if (count < MIN_PARALLEL_ELEMENTS) {
+		return unserialize(data, length);
+	}
+
+	// Find the boundaries of the elements, without decoding them; if the
+	// data is not valid, unserialize() reports the error
+	std::vector <std::size_t> offsets(count + 1);
+	std::size_t pos = tokenizer.position();
+
+	for (std::size_t i = 0 ; i < count ; ++i) {
+
+		offsets[i] = pos;
+
+		std::size_t keyLength, valueLength;
+
+		if ((pos < length && data[pos] == '}') ||
+		    !validatePrefix(data + pos, length - pos, keyLength, MAX_SCAN_DEPTH).valid ||
+		    !validatePrefix(data + pos + keyLength, length - pos - keyLength, valueLength, MAX_SCAN_DEPTH).valid) {
+
+			return unserialize(data, length);
+		}
+
+		pos += keyLength + valueLength;
+	}
+
+	offsets[count] = pos;
+
+	if (pos == length || data[pos] != '}' || pos + 1 != length) {
+
+		return unserialize(data, length);
+	}
+
+	// Decode the elements
+	std::vector <MixedArray::Entry> entries(count);
+
+	const std::size_t rangeCount = std::min(count, m_queues.size() * RANGES_PER_THREAD);
+
+	ArrayJob job(data, offsets, rangeCount, entries);
+	runJob(job, rangeCount);
+
+	job.rethrowError();
+
+	// Keys are consecutive integers starting from 0 for a vector,
+	// as in Unserializer
+	bool isVector = true;
+
+	for (std::size_t i = 0 ; isVector && i < count ; ++i) {
+
+		isVector = (entries[i].first.type() == Mixed::TYPE_INT &&
+		            entries[i].first.intValue() == static_cast <std::int64_t>(i));
+	}
+
+	if (!isVector) {
+		return make_shared <Mixed>(MixedArray(std::move(entries)));
+	}
+
+	std::vector <Mixed> vector;
+	vector.reserve(count);
+
+	for (std::size_t i = 0 ; i < count ; ++i) {
+		vector.push_back(std::move(entries[i].second));
+	}
+
+	return make_shared <Mixed>(MixedArray(std::move(vector)));
+}
+
+
+void BatchUnserializer::runJob(Job &job, const std::size_t taskCount) {
+
+	if (taskCount == 0) {
+		return;
+	}
+
+	std::lock_guard <std::mutex> jobLock(m_jobMutex);
+
+	// Give each worker an even share of the tasks; no worker is
+	// running at this point, as the previous job is complete
+	const std::size_t workers = m_queues.size();
+
+	for (std::size_t i = 0 ; i < workers ; ++i) {
+
+		std::lock_guard <std::mutex> lock(m_queues[i].mutex);
+
+		m_queues[i].begin = taskCount * i / workers;
+		m_queues[i].end = taskCount * (i + 1) / workers;
+	}
+
+	{
+		std::lock_guard <std::mutex> lock(m_mutex);
+
+		m_job = &job;
+		m_active = true;
+		++m_generation;
+	}
+
+	m_workAvailable.notify_all();
+
+	work(0);
+
+	// Wait for the tasks being run by other threads; no task is
+	// left in the queues once a worker has run out of work
+	{
+		std::unique_lock <std::mutex> lock(m_mutex);
+
+		while (m_busyThreads != 0) {
+			m_workDone.wait(lock);
+		}
+
+		m_active = false;
+		m_job = NULL;
+	}
+}
+
+
+void BatchUnserializer::threadMain(const std::size_t worker) {
+
+	std::size_t generation = 0;
+
+	std::unique_lock <std::mutex> lock(m_mutex);
+
+	for (;;) {
+
+		while (!m_stopping && m_generation == generation) {
+			m_workAvailable.wait(lock);
+		}
+
+		if (m_stopping) {
+			return;
+		}
+
+		generation = m_generation;
+
+		// The job may already be complete if this thread woke up late
+		if (!m_active) {
+			continue;
+		}
+
+		++m_busyThreads;
+
+		lock.unlock();
+		work(worker);
+		lock.lock();
+
+		if (--m_busyThreads == 0) {
+			m_workDone.notify_all();
+		}
+	}
+}
+
+
+void BatchUnserializer::work(const std::size_t worker) {
+
+	std::size_t task;
+
+	while (take(worker, task)) {
+		m_job->run(task);
+	}
+}
+
+
+bool BatchUnserializer::take(const std::size_t worker, std::size_t &task) {
+
+	WorkQueue &queue = m_queues[worker];
+
+	do {
+
+		std::lock_guard <std::mutex> lock(queue.mutex);
+
+		if (queue.begin != queue.end) {
+			task = queue.begin++;
+			return true;
+		}
+
+	} while (steal(worker));
+
+	return false;
+}
+
+
+bool BatchUnserializer::steal(const std::size_t worker) {
+
+	const std::size_t workers = m_queues.size();
+
+	// Start with the next worker, so that idle workers do not all
+	// compete for the same victim
+	for (std::size_t n = 1 ; n < workers ; ++n) {
+
+		WorkQueue &victim = m_queues[(worker + n) % workers];
+
+		std::size_t begin, end;
+
+		{
+			std::lock_guard <std::mutex> lock(victim.mutex);
+
+			const std::size_t remaining = victim.end - victim.begin;
+
+			if (remaining == 0) {
+				continue;
+			}
+
+			// Take the second half of the remaining tasks
+			end = victim.end;
+			begin = end - (remaining + 1) / 2;
+
+			victim.end = begin;
+		}
+
+		// Only this thread refills its own queue, which is empty here
+		WorkQueue &queue = m_queues[worker];
+
+		std::lock_guard <std::mutex> lock(queue.mutex);
+
+		queue.begin = begin;
+		queue.end = end;
+
+		return true;
+	}
+
+	return false;
+}
+
+
+} // namespace pherialize
@@ -0,0 +1,201 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_BATCHUNSERIALIZER_HPP_INCLUDED
+#define PHERIALIZE_BATCHUNSERIALIZER_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+#include "pherialize/export.hpp"
+
+#include "pherialize/Mixed.hpp"
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+
+namespace pherialize {
+
+
+/** An input of a batch: a caller-owned buffer of serialized data.
+  */
+struct PHERIALIZE_EXPORT BatchInput {
+
+	const char *data;
+	std::size_t length;
+};
+
+
+/** The result of the unserialization of an input of a batch.
+  */
+struct PHERIALIZE_EXPORT BatchResult {
+
+	BatchResult() : ok(false) { }
+
+	/** Whether the input has been unserialized successfully. */
+	bool ok;
+
+	/** Unserialized value, or NULL if the input is empty or invalid. */
+	shared_ptr <Mixed> value;
+
+	/** Error message, if the input is invalid. */
+	std::string error;
+};
+
+
+/** Unserializes batches of independent inputs on a pool of threads.
+  *
+  * The inputs of a batch are split evenly between the threads; a thread
+  * which runs out of inputs steals half of the remaining inputs of
+  * another one, so that a few large inputs do not stall the batch. The
+  * calling thread takes part in the work, and the other threads are
+  * kept between batches.
+  *
+  * The same pool can also decode the elements of a single large array
+  * in parallel, with unserializeParallel().
+  *
+  * Calls made concurrently on the same instance are run one after
+  * the other.
+  */
+class PHERIALIZE_EXPORT BatchUnserializer {
+
+public:
+
+	/** Constructs a new batch unserializer.
+	  *
+	  * @param threadCount number of threads to use, including the
+	  * calling thread, or 0 to use one thread per hardware thread
+	  */
+	BatchUnserializer(const std::size_t threadCount = 0);
+
+	~BatchUnserializer();
+
+	/** Returns the number of threads used, including the calling thread.
+	  *
+	  * @return number of threads
+	  */
+	std::size_t threadCount() const;
+
+	/** Unserializes a batch of inputs. Errors are reported per input,
+	  * and do not affect the other inputs. Each input must hold a single
+	  * value, as with unserialize().
+	  *
+	  * @param inputs inputs to unserialize; the data must remain valid
+	  * until the function returns
+	  * @param count number of inputs
+	  * @return one result per input, in the same order
+	  */
+	std::vector <BatchResult> unserializeBatch(const BatchInput *inputs, const std::size_t count);
+
+	/** Unserializes a batch of strings. See unserializeBatch(const
+	  * BatchInput *, const std::size_t).
+	  *
+	  * @param inputs strings to unserialize
+	  * @return one result per input, in the same order
+	  */
+	std::vector <BatchResult> unserializeBatch(const std::vector <std::string> &inputs);
+
+	/** Unserializes a single value, decoding the elements of a large
+	  * top-level array in parallel.
+	  *
+	  * The boundaries of the elements are first found by a structural
+	  * scan, which skips strings using their length prefix; ranges of
+	  * elements are then unserialized on the threads, and the results
+	  * are joined into a single array. Small arrays and other values are
+	  * unserialized as with unserialize(), as is invalid data, so that
+	  * the same errors are reported.
+	  *
+	  * @param data pointer to serialized data (need not be NUL-terminated)
+	  * @param length length of data, in bytes
+	  * @throw std::runtime_error if a parsing error occurs
+	  * @return a Mixed object, or NULL if the data is empty
+	  */
+	shared_ptr <Mixed> unserializeParallel(const char *data, const std::size_t length);
+
+	/** Unserializes a single value, decoding the elements of a large
+	  * top-level array in parallel. See unserializeParallel(const char *,
+	  * const std::size_t).
+	  *
+	  * @param str string containing serialized data
+	  * @throw std::runtime_error if a parsing error occurs
+	  * @return a Mixed object, or NULL if the string is empty
+	  */
+	shared_ptr <Mixed> unserializeParallel(const std::string &str);
+
+private:
+
+	BatchUnserializer(const BatchUnserializer &);
+	BatchUnserializer &operator=(const BatchUnserializer &);
+
+
+	// Work split into numbered tasks; run() must not throw
+	class Job {
+
+	public:
+
+		virtual ~Job() { }
+		virtual void run(const std::size_t task) = 0;
+	};
+
+	class BatchJob;
+	class ArrayJob;
+
+	// Range of tasks not run yet by a worker
+	struct WorkQueue {
+		std::mutex mutex;
+		std::size_t begin;
+		std::size_t end;
+	};
+
+
+	void runJob(Job &job, const std::size_t taskCount);
+
+	void threadMain(const std::size_t worker);
+	void work(const std::size_t worker);
+	bool take(const std::size_t worker, std::size_t &task);
+	bool steal(const std::size_t worker);
+
+
+	std::vector <std::thread> m_threads;
+	std::vector <WorkQueue> m_queues;
+
+	// Serializes jobs
+	std::mutex m_jobMutex;
+
+	// Protects the fields below
+	std::mutex m_mutex;
+	std::condition_variable m_workAvailable;
+	std::condition_variable m_workDone;
+	std::size_t m_generation;
+	std::size_t m_busyThreads;
+	bool m_active;
+	bool m_stopping;
+
+	// Current job
+	Job *m_job;
+};
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_BATCHUNSERIALIZER_HPP_INCLUDED
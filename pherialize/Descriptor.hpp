@@ -0,0 +1,178 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_DESCRIPTOR_HPP_INCLUDED
+#define PHERIALIZE_DESCRIPTOR_HPP_INCLUDED
+
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace pherialize {
+
+
+/** Describes the fields of a struct, so that it can be read directly
+  * from serialized data with unserializeAs(), and written with
+  * serializeFrom(), without building Mixed values.
+  *
+  * Specialize it for each struct, with a static function which passes
+  * the name and the member pointer of each field to a visitor:
+  *
+  * \code
+  * struct Session {
+  *     int userId;
+  *     std::string login;
+  *     boost::optional <std::string> locale;
+  *     std::vector <std::string> roles;
+  * };
+  *
+  * namespace pherialize {
+  *
+  * template <>
+  * struct Descriptor <Session> {
+  *
+  *     template <typename Visitor>
+  *     static void describe(Visitor &v) {
+  *
+  *         v.field("user_id", &Session::userId);
+  *         v.field("login", &Session::login);
+  *         v.field("locale", &Session::locale);
+  *         v.field("roles", &Session::roles);
+  *     }
+  * };
+  *
+  * }
+  * \endcode
+  *
+  * Field names are the keys of the PHP array (or the property names of
+  * the PHP object). Fields may be of integer, bool, double or string
+  * type, std::vector, std::map, boost::optional, or another struct which
+  * has a descriptor.
+  */
+template <typename T>
+struct Descriptor;
+
+
+namespace detail {
+
+
+inline void appendUnsigned(std::string &out, std::uint64_t v) {
+
+	char buffer[20];
+	char *p = buffer + sizeof(buffer);
+
+	do {
+		*--p = static_cast <char>('0' + v % 10);
+		v /= 10;
+	} while (v != 0);
+
+	out.append(p, buffer + sizeof(buffer) - p);
+}
+
+
+inline void encodeString(std::string &out, const char *str, const std::size_t length) {
+
+	out.append("s:", 2);
+	appendUnsigned(out, length);
+	out.append(":\"", 2);
+	out.append(str, length);
+	out.append("\";", 2);
+}
+
+
+/** Serialized fragments which do not depend on the values of a struct:
+  * the array header, and the key of each field. They are written as is
+  * by serializeFrom(), and matched byte for byte by unserializeAs().
+  * The length of each field name is also recorded, so that keys in the
+  * data can be compared with the names without measuring them.
+  */
+struct StructFragments {
+
+	std::string header;
+	std::vector <std::string> keys;
+	std::vector <std::size_t> nameLengths;
+};
+
+
+/** Visitor which builds the key fragment of each field.
+  */
+class FieldKeyCollector {
+
+public:
+
+	FieldKeyCollector(StructFragments &fragments)
+		: m_fragments(fragments) {
+
+	}
+
+	template <typename T, typename M>
+	void field(const char *name, M T::*) {
+
+		const std::size_t length = std::char_traits <char>::length(name);
+
+		std::string key;
+		encodeString(key, name, length);
+
+		m_fragments.keys.push_back(key);
+		m_fragments.nameLengths.push_back(length);
+	}
+
+private:
+
+	StructFragments &m_fragments;
+};
+
+
+/** Returns the fragments of a struct, which are built once.
+  */
+template <typename T>
+const StructFragments &structFragments() {
+
+	struct Builder {
+
+		static StructFragments build() {
+
+			StructFragments fragments;
+
+			FieldKeyCollector collector(fragments);
+			Descriptor <T>::describe(collector);
+
+			fragments.header.append("a:", 2);
+			appendUnsigned(fragments.header, fragments.keys.size());
+			fragments.header.append(":{", 2);
+
+			return fragments;
+		}
+	};
+
+	static const StructFragments fragments = Builder::build();
+
+	return fragments;
+}
+
+
+} // namespace detail
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_DESCRIPTOR_HPP_INCLUDED
@@ -0,0 +1,399 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "pherialize/Document.hpp"
+
+#include <stdexcept>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+#include <map>
+
+#include <boost/format.hpp>
+
+
+
+namespace pherialize {
+
+
+DocumentValue::DocumentValue() {
+
+	m_type = Mixed::TYPE_NULL;
+	m_arrayType = MixedArray::TYPE_NONE;
+}
+
+
+void DocumentValue::checkType(const Mixed::Type type, const char *name) const {
+
+	if (m_type != type) {
+		throw std::runtime_error(
+			(boost::format("Invalid value type for '%1%'.") % name).str()
+		);
+	}
+}
+
+
+Mixed::Type DocumentValue::type() const {
+	return m_type;
+}
+
+
+bool DocumentValue::isNull() const {
+	return m_type == Mixed::TYPE_NULL;
+}
+
+
+const char *DocumentValue::stringData() const {
+	checkType(Mixed::TYPE_STRING, "string");
+	return m_value.stringValue.data;
+}
+
+
+std::size_t DocumentValue::stringLength() const {
+	checkType(Mixed::TYPE_STRING, "string");
+	return m_value.stringValue.length;
+}
+
+
+std::string DocumentValue::stringValue() const {
+	checkType(Mixed::TYPE_STRING, "string");
+	return std::string(m_value.stringValue.data, m_value.stringValue.length);
+}
+
+
+std::int64_t DocumentValue::intValue() const {
+	checkType(Mixed::TYPE_INT, "int");
+	return m_value.intValue;
+}
+
+
+bool DocumentValue::boolValue() const {
+	checkType(Mixed::TYPE_BOOL, "bool");
+	return m_value.boolValue;
+}
+
+
+double DocumentValue::doubleValue() const {
+	checkType(Mixed::TYPE_DOUBLE, "double");
+	return m_value.doubleValue;
+}
+
+
+MixedArray::Type DocumentValue::arrayType() const {
+	checkType(Mixed::TYPE_ARRAY, "array");
+	return m_arrayType;
+}
+
+
+std::size_t DocumentValue::size() const {
+	checkType(Mixed::TYPE_ARRAY, "array");
+	return m_value.arrayValue.count;
+}
+
+
+const DocumentValue &DocumentValue::key(const std::size_t index) const {
+
+	if (index >= size()) {
+		throw std::out_of_range("Array index out of range.");
+	}
+
+	return m_value.arrayValue.elements[index * 2];
+}
+
+
+const DocumentValue &DocumentValue::value(const std::size_t index) const {
+
+	if (index >= size()) {
+		throw std::out_of_range("Array index out of range.");
+	}
+
+	return m_value.arrayValue.elements[index * 2 + 1];
+}
+
+
+const DocumentValue *DocumentValue::find(const std::string &key) const {
+
+	return find(key.data(), key.length());
+}
+
+
+const DocumentValue *DocumentValue::find(const char *key, const std::size_t length) const {
+
+	const std::size_t count = size();
+	const DocumentValue *elements = m_value.arrayValue.elements;
+
+	for (std::size_t i = 0 ; i < count ; ++i) {
+
+		const DocumentValue &k = elements[i * 2];
+
+		if (k.m_type == Mixed::TYPE_STRING &&
+		    k.m_value.stringValue.length == length &&
+		    std::memcmp(k.m_value.stringValue.data, key, length) == 0) {
+
+			return &elements[i * 2 + 1];
+		}
+	}
+
+	return NULL;
+}
+
+
+const DocumentValue *DocumentValue::find(const std::int64_t key) const {
+
+	const std::size_t count = size();
+	const DocumentValue *elements = m_value.arrayValue.elements;
+
+	if (m_arrayType == MixedArray::TYPE_VECTOR) {
+		return key >= 0 && static_cast <std::size_t>(key) < count ? &elements[key * 2 + 1] : NULL;
+	}
+
+	for (std::size_t i = 0 ; i < count ; ++i) {
+
+		const DocumentValue &k = elements[i * 2];
+
+		if (k.m_type == Mixed::TYPE_INT && k.m_value.intValue == key) {
+			return &elements[i * 2 + 1];
+		}
+	}
+
+	return NULL;
+}
+
+
+Mixed DocumentValue::toMixed() const {
+
+	switch (m_type) {
+
+		case Mixed::TYPE_STRING:
+
+			return Mixed(std::string(m_value.stringValue.data, m_value.stringValue.length));
+
+		case Mixed::TYPE_INT:
+
+			return Mixed(m_value.intValue);
+
+		case Mixed::TYPE_BOOL:
+
+			return Mixed(m_value.boolValue);
+
+		case Mixed::TYPE_DOUBLE:
+
+			return Mixed(m_value.doubleValue);
+
+		case Mixed::TYPE_ARRAY: {
+
+			const std::size_t count = m_value.arrayValue.count;
+			const DocumentValue *elements = m_value.arrayValue.elements;
+
+			if (m_arrayType == MixedArray::TYPE_VECTOR) {
+
+				std::vector <Mixed> vector;
+				vector.reserve(count);
+
+				for (std::size_t i = 0 ; i < count ; ++i) {
+					vector.push_back(elements[i * 2 + 1].toMixed());
+				}
+
+				return Mixed(MixedArray(std::move(vector)));
+
+			} else {
+
+				std::vector <MixedArray::Entry> entries;
+				entries.reserve(count);
+
+				for (std::size_t i = 0 ; i < count ; ++i) {
+					entries.emplace_back(elements[i * 2].toMixed(), elements[i * 2 + 1].toMixed());
+				}
+
+				return Mixed(MixedArray(std::move(entries)));
+			}
+		}
+		case Mixed::TYPE_NULL:
+
+			break;
+	}
+
+	return Mixed();
+}
+
+
+
+Document::Document() {
+
+	m_root = NULL;
+}
+
+
+void Document::parse(const std::string &data) {
+
+	parse(data.data(), data.length());
+}
+
+
+void Document::parse(const char *data, const std::size_t length) {
+
+	clear();
+
+	Tokenizer tokenizer(data, length);
+
+	if (tokenizer.remaining() == 0) {
+		return;
+	}
+
+	try {
+
+		DocumentValue *root = new (m_arena.allocateArray <DocumentValue>(1)) DocumentValue;
+
+		parseValue(tokenizer, *root);
+
+		if (tokenizer.remaining() != 0) {
+			throw std::runtime_error("Expected end of data.");
+		}
+
+		m_root = root;
+
+	} catch (...) {
+
+		clear();
+		throw;
+	}
+}
+
+
+void Document::parseValue(Tokenizer &tokenizer, DocumentValue &value) {
+
+	switch (tokenizer.readType()) {
+
+		case 's': {
+
+			const char *str;
+			std::size_t length;
+
+			tokenizer.readString(str, length);
+
+			char *copy = static_cast <char *>(m_arena.allocate(length, 1));
+			std::memcpy(copy, str, length);
+
+			value.m_type = Mixed::TYPE_STRING;
+			value.m_value.stringValue.data = copy;
+			value.m_value.stringValue.length = length;
+
+			return;
+		}
+		case 'i':
+
+			value.m_type = Mixed::TYPE_INT;
+			value.m_value.intValue = tokenizer.readInt();
+			return;
+
+		case 'a':
+
+			parseArrayElements(tokenizer, value, tokenizer.readArrayBegin());
+			return;
+
+		case 'O': {
+
+			const char *className;
+			std::size_t classNameLength;
+
+			parseArrayElements(tokenizer, value, tokenizer.readObjectBegin(className, classNameLength));
+			return;
+		}
+		case 'N':
+
+			tokenizer.readNull();
+			value.m_type = Mixed::TYPE_NULL;
+			return;
+
+		case 'b':
+
+			value.m_type = Mixed::TYPE_BOOL;
+			value.m_value.boolValue = tokenizer.readBool();
+			return;
+
+		case 'd':
+
+			value.m_type = Mixed::TYPE_DOUBLE;
+			value.m_value.doubleValue = tokenizer.readDouble();
+			return;
+	}
+
+	throw std::runtime_error("Unexpected end of data.");
+}
+
+
+void Document::parseArrayElements(Tokenizer &tokenizer, DocumentValue &value, const std::size_t count) {
+
+	// The count has been checked by the tokenizer against the size of the data
+	DocumentValue *elements = m_arena.allocateArray <DocumentValue>(count * 2);
+
+	for (std::size_t i = 0 ; i < count * 2 ; ++i) {
+		new (&elements[i]) DocumentValue;
+	}
+
+	value.m_type = Mixed::TYPE_ARRAY;
+	value.m_arrayType = MixedArray::TYPE_VECTOR;
+	value.m_value.arrayValue.elements = elements;
+	value.m_value.arrayValue.count = count;
+
+	for (std::size_t i = 0 ; i < count ; ++i) {
+
+		tokenizer.expectElement();
+
+		DocumentValue &key = elements[i * 2];
+
+		parseValue(tokenizer, key);
+
+		if (key.m_type != Mixed::TYPE_INT || key.m_value.intValue != static_cast <std::int64_t>(i)) {
+			value.m_arrayType = MixedArray::TYPE_MAP;
+		}
+
+		parseValue(tokenizer, elements[i * 2 + 1]);
+	}
+
+	tokenizer.expectArrayEnd();
+}
+
+
+void Document::clear() {
+
+	m_root = NULL;
+	m_arena.clear();
+}
+
+
+bool Document::empty() const {
+	return m_root == NULL;
+}
+
+
+const DocumentValue &Document::root() const {
+
+	static const DocumentValue null;
+
+	return m_root ? *m_root : null;
+}
+
+
+std::size_t Document::memoryUsage() const {
+	return m_arena.capacity();
+}
+
+
+} // namespace pherialize
@@ -0,0 +1,276 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_DOCUMENT_HPP_INCLUDED
+#define PHERIALIZE_DOCUMENT_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+#include "pherialize/export.hpp"
+
+#include "pherialize/Arena.hpp"
+#include "pherialize/Mixed.hpp"
+#include "pherialize/MixedArray.hpp"
+#include "pherialize/Tokenizer.hpp"
+
+#include <string>
+#include <cstddef>
+
+
+namespace pherialize {
+
+
+class Document;
+
+
+/** A read-only value owned by a Document.
+  *
+  * Arrays are stored as a contiguous sequence of key/value pairs,
+  * in the order in which they appear in the serialized data.
+  */
+class PHERIALIZE_EXPORT DocumentValue {
+
+	friend class Document;
+
+public:
+
+	/** Returns the type of the value.
+	  *
+	  * @return value type
+	  */
+	Mixed::Type type() const;
+
+	/** Returns whether this is the null value.
+	  *
+	  * @return true if the value is null, or false otherwise
+	  */
+	bool isNull() const;
+
+	/** Returns a pointer to the characters of a string value.
+	  * The string is not NUL-terminated.
+	  *
+	  * @throw std::runtime_error if the value is not a string
+	  * @return pointer to the first character of the string
+	  */
+	const char *stringData() const;
+
+	/** Returns the length of a string value.
+	  *
+	  * @throw std::runtime_error if the value is not a string
+	  * @return length of the string, in bytes
+	  */
+	std::size_t stringLength() const;
+
+	/** Returns a copy of a string value.
+	  *
+	  * @throw std::runtime_error if the value is not a string
+	  * @return string value
+	  */
+	std::string stringValue() const;
+
+	/** Returns the value as an int.
+	  *
+	  * @throw std::runtime_error if the value is not an int
+	  * @return int value
+	  */
+	std::int64_t intValue() const;
+
+	/** Returns the value as a bool.
+	  *
+	  * @throw std::runtime_error if the value is not a bool
+	  * @return bool value
+	  */
+	bool boolValue() const;
+
+	/** Returns the value as a double.
+	  *
+	  * @throw std::runtime_error if the value is not a double
+	  * @return double value
+	  */
+	double doubleValue() const;
+
+	/** Returns the kind of array, as Unserializer would build it:
+	  * a vector if keys are consecutive integers starting from 0,
+	  * or a map otherwise.
+	  *
+	  * @throw std::runtime_error if the value is not an array
+	  * @return array type
+	  */
+	MixedArray::Type arrayType() const;
+
+	/** Returns the number of elements of an array.
+	  *
+	  * @throw std::runtime_error if the value is not an array
+	  * @return number of elements
+	  */
+	std::size_t size() const;
+
+	/** Returns the key of an array element.
+	  *
+	  * @param index element index, in document order
+	  * @throw std::out_of_range if the index is out of range
+	  * @return element key
+	  */
+	const DocumentValue &key(const std::size_t index) const;
+
+	/** Returns the value of an array element.
+	  *
+	  * @param index element index, in document order
+	  * @throw std::out_of_range if the index is out of range
+	  * @return element value
+	  */
+	const DocumentValue &value(const std::size_t index) const;
+
+	/** Finds an array element by string key.
+	  *
+	  * @param key key to search for
+	  * @throw std::runtime_error if the value is not an array
+	  * @return element value, or NULL if there is no such key
+	  */
+	const DocumentValue *find(const std::string &key) const;
+
+	/** Finds an array element by string key.
+	  *
+	  * @param key pointer to key characters
+	  * @param length length of key
+	  * @throw std::runtime_error if the value is not an array
+	  * @return element value, or NULL if there is no such key
+	  */
+	const DocumentValue *find(const char *key, const std::size_t length) const;
+
+	/** Finds an array element by integer key.
+	  *
+	  * @param key key to search for
+	  * @throw std::runtime_error if the value is not an array
+	  * @return element value, or NULL if there is no such key
+	  */
+	const DocumentValue *find(const std::int64_t key) const;
+
+	/** Converts this value and its children to a Mixed value,
+	  * which does not depend on the document.
+	  *
+	  * @return a Mixed value
+	  */
+	Mixed toMixed() const;
+
+private:
+
+	DocumentValue();
+
+
+	struct StringValue {
+		const char *data;
+		std::size_t length;
+	};
+
+	struct ArrayValue {
+		DocumentValue *elements;  // key/value pairs
+		std::size_t count;
+	};
+
+	union ValueType {
+		StringValue stringValue;
+		std::int64_t intValue;
+		bool boolValue;
+		double doubleValue;
+		ArrayValue arrayValue;
+	};
+
+
+	void checkType(const Mixed::Type type, const char *name) const;
+
+
+	Mixed::Type m_type;
+	MixedArray::Type m_arrayType;
+	ValueType m_value;
+};
+
+
+/** A tree of values unserialized into a memory arena.
+  *
+  * All the values and string characters of a document are allocated
+  * from a single arena, which makes parsing cheaper than building Mixed
+  * values, and releases the whole tree at once when the document is
+  * cleared or destroyed. The serialized data is not referenced after
+  * parsing.
+  */
+class PHERIALIZE_EXPORT Document {
+
+public:
+
+	Document();
+
+	/** Unserializes a character string into this document,
+	  * replacing its previous contents.
+	  *
+	  * @param data string containing serialized data
+	  * @throw std::runtime_error if a parsing error occurs
+	  */
+	void parse(const std::string &data);
+
+	/** Unserializes a buffer into this document, replacing its
+	  * previous contents.
+	  *
+	  * @param data pointer to serialized data
+	  * @param length length of data, in bytes
+	  * @throw std::runtime_error if a parsing error occurs
+	  */
+	void parse(const char *data, const std::size_t length);
+
+	/** Releases all the values of this document.
+	  */
+	void clear();
+
+	/** Returns whether this document holds no value, either because
+	  * nothing has been parsed or because the data was empty.
+	  *
+	  * @return true if the document is empty, or false otherwise
+	  */
+	bool empty() const;
+
+	/** Returns the top-level value of this document.
+	  *
+	  * @return root value, or a null value if the document is empty
+	  */
+	const DocumentValue &root() const;
+
+	/** Returns the amount of memory held by this document.
+	  *
+	  * @return size in bytes
+	  */
+	std::size_t memoryUsage() const;
+
+private:
+
+	Document(const Document &);
+	Document &operator=(const Document &);
+
+
+	void parseValue(Tokenizer &tokenizer, DocumentValue &value);
+	void parseArrayElements(Tokenizer &tokenizer, DocumentValue &value, const std::size_t count);
+
+
+	Arena m_arena;
+	DocumentValue *m_root;
+};
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_DOCUMENT_HPP_INCLUDED
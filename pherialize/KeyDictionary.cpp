@@ -0,0 +1,181 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "pherialize/KeyDictionary.hpp"
+
+#include <cstring>
+
+
+
+namespace pherialize {
+
+
+// Identifies dictionaries, so that interned strings of different
+// dictionaries are never assumed to differ (addresses may be reused)
+static std::atomic <std::uint64_t> nextDictionaryId(1);
+
+
+static std::uint32_t hashString(const char *str, const std::size_t length) {
+
+	// FNV-1a
+	std::uint32_t h = 2166136261u;
+
+	for (std::size_t i = 0 ; i < length ; ++i) {
+		h ^= static_cast <unsigned char>(str[i]);
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+
+
+InternedString::InternedString
+	(const std::uint64_t dictionaryId, const std::uint32_t hash, const char *str, const std::size_t length)
+	: m_refCount(1), m_dictionaryId(dictionaryId), m_hash(hash), m_value(str, length) {
+
+}
+
+
+void InternedString::acquire() {
+
+	m_refCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void InternedString::release() {
+
+	if (m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		delete this;
+	}
+}
+
+
+const std::string &InternedString::value() const {
+
+	return m_value;
+}
+
+
+
+KeyDictionary::KeyDictionary(const std::size_t maxKeys, const std::size_t maxKeyLength)
+	: m_id(nextDictionaryId++), m_maxKeys(maxKeys), m_maxKeyLength(maxKeyLength), m_size(0) {
+
+	std::size_t slotCount = 8;
+
+	while (slotCount < maxKeys * 2) {
+		slotCount *= 2;
+	}
+
+	std::vector <std::atomic <InternedString *> > slots(slotCount);
+
+	for (std::size_t i = 0 ; i < slotCount ; ++i) {
+		slots[i].store(NULL, std::memory_order_relaxed);
+	}
+
+	m_slots.swap(slots);
+}
+
+
+KeyDictionary::~KeyDictionary() {
+
+	for (std::size_t i = 0 ; i < m_slots.size() ; ++i) {
+
+		if (InternedString *str = m_slots[i].load(std::memory_order_relaxed)) {
+			str->release();
+		}
+	}
+}
+
+
+std::size_t KeyDictionary::findSlot(const std::uint32_t hash, const char *str, const std::size_t length) const {
+
+	const std::size_t mask = m_slots.size() - 1;
+
+	for (std::size_t i = hash & mask ; ; i = (i + 1) & mask) {
+
+		const InternedString *s = m_slots[i].load(std::memory_order_acquire);
+
+		if (s == NULL ||
+		    (s->m_hash == hash && s->m_value.length() == length &&
+		     std::memcmp(s->m_value.data(), str, length) == 0)) {
+
+			return i;
+		}
+	}
+}
+
+
+Mixed KeyDictionary::intern(const char *str, const std::size_t length, InternResult *result) {
+
+	InternResult dummy;
+	InternResult &res = (result != NULL) ? *result : dummy;
+
+	if (length > m_maxKeyLength) {
+		res = INTERN_NOT_ADDED;
+		return Mixed(std::string(str, length));
+	}
+
+	const std::uint32_t hash = hashString(str, length);
+
+	std::size_t slot = findSlot(hash, str, length);
+
+	if (InternedString *s = m_slots[slot].load(std::memory_order_acquire)) {
+		res = INTERN_FOUND;
+		return Mixed(s);
+	}
+
+	// Not found: look again under the lock, as another thread may
+	// have inserted the string in the meantime
+	std::lock_guard <std::mutex> lock(m_mutex);
+
+	slot = findSlot(hash, str, length);
+
+	if (InternedString *s = m_slots[slot].load(std::memory_order_relaxed)) {
+		res = INTERN_FOUND;
+		return Mixed(s);
+	}
+
+	if (m_size.load(std::memory_order_relaxed) >= m_maxKeys) {
+		res = INTERN_NOT_ADDED;
+		return Mixed(std::string(str, length));
+	}
+
+	InternedString *s = new InternedString(m_id, hash, str, length);
+
+	m_slots[slot].store(s, std::memory_order_release);
+	m_size.fetch_add(1, std::memory_order_relaxed);
+
+	res = INTERN_ADDED;
+	return Mixed(s);
+}
+
+
+Mixed KeyDictionary::intern(const std::string &str) {
+
+	return intern(str.data(), str.length());
+}
+
+
+std::size_t KeyDictionary::size() const {
+
+	return m_size.load(std::memory_order_relaxed);
+}
+
+
+} // namespace pherialize
@@ -0,0 +1,160 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_KEYDICTIONARY_HPP_INCLUDED
+#define PHERIALIZE_KEYDICTIONARY_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+#include "pherialize/export.hpp"
+
+#include "pherialize/Mixed.hpp"
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace pherialize {
+
+
+/** An immutable string shared by Mixed values, and owned by them
+  * and by the dictionary which created it.
+  */
+class PHERIALIZE_EXPORT InternedString {
+
+public:
+
+	InternedString(const std::uint64_t dictionaryId, const std::uint32_t hash, const char *str, const std::size_t length);
+
+	void acquire();
+	void release();
+
+	const std::string &value() const;
+
+private:
+
+	InternedString(const InternedString &);
+	InternedString &operator=(const InternedString &);
+
+	friend class KeyDictionary;
+	friend class Mixed;
+
+
+	std::atomic <std::size_t> m_refCount;
+	const std::uint64_t m_dictionaryId;
+	const std::uint32_t m_hash;
+	const std::string m_value;
+};
+
+
+/** A set of interned strings, shared by unserializers so that the
+  * keys which are repeated across payloads (such as the keys of PHP
+  * sessions) are stored once, and compared by address.
+  *
+  * Lookups are lock-free, so that many threads can share the same
+  * dictionary; only the insertion of a new string takes a lock. The
+  * number of strings is bounded: once it is reached, or for longer
+  * strings, intern() returns a regular (not interned) string. Strings
+  * are never removed from the dictionary, but they are reference
+  * counted, so that values may outlive it.
+  */
+class PHERIALIZE_EXPORT KeyDictionary {
+
+public:
+
+	/** Default maximum number of strings. */
+	static const std::size_t DEFAULT_MAX_KEYS = 4096;
+
+	/** Default maximum length of a string to intern, in bytes. */
+	static const std::size_t DEFAULT_MAX_KEY_LENGTH = 64;
+
+	/** Possible outcomes of intern().
+	  */
+	enum InternResult {
+		INTERN_FOUND,       // the string was in the dictionary
+		INTERN_ADDED,       // the string has been added to the dictionary
+		INTERN_NOT_ADDED    // the string is too long, or the dictionary is full
+	};
+
+
+	/** Constructs an empty dictionary.
+	  *
+	  * @param maxKeys maximum number of strings
+	  * @param maxKeyLength maximum length of a string to intern, in bytes
+	  */
+	KeyDictionary(const std::size_t maxKeys = DEFAULT_MAX_KEYS,
+	              const std::size_t maxKeyLength = DEFAULT_MAX_KEY_LENGTH);
+
+	~KeyDictionary();
+
+	/** Returns a string value, interned if possible. This function
+	  * can be called from several threads at the same time.
+	  *
+	  * @param str pointer to the characters of the string
+	  * @param length length of the string, in bytes
+	  * @param result if not NULL, receives how the value was obtained
+	  * @return string value
+	  */
+	Mixed intern(const char *str, const std::size_t length, InternResult *result = NULL);
+
+	/** Returns a string value, interned if possible. See intern(const
+	  * char *, const std::size_t).
+	  *
+	  * @param str string
+	  * @return string value
+	  */
+	Mixed intern(const std::string &str);
+
+	/** Returns the number of strings in the dictionary.
+	  *
+	  * @return number of strings
+	  */
+	std::size_t size() const;
+
+private:
+
+	KeyDictionary(const KeyDictionary &);
+	KeyDictionary &operator=(const KeyDictionary &);
+
+
+	// Returns the slot which holds the string, or the empty slot
+	// at which it should be inserted
+	std::size_t findSlot(const std::uint32_t hash, const char *str, const std::size_t length) const;
+
+
+	const std::uint64_t m_id;
+	const std::size_t m_maxKeys;
+	const std::size_t m_maxKeyLength;
+
+	// Open-addressing table, at most half full; slots are only
+	// written under the mutex, and never cleared
+	std::vector <std::atomic <InternedString *> > m_slots;
+	std::atomic <std::size_t> m_size;
+
+	std::mutex m_mutex;
+};
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_KEYDICTIONARY_HPP_INCLUDED
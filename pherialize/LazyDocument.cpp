@@ -0,0 +1,419 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "pherialize/LazyDocument.hpp"
+#include "pherialize/Tokenizer.hpp"
+#include "pherialize/unserialize.hpp"
+
+#include <stdexcept>
+#include <cstring>
+#include <utility>
+
+#include <boost/format.hpp>
+
+
+
+namespace pherialize {
+
+
+LazyValue::LazyValue(const LazyDocument *document, const std::size_t offset) {
+
+	m_document = document;
+	m_offset = offset;
+	m_end = 0;
+	m_firstElement = 0;
+	m_count = 0;
+	m_arrayType = MixedArray::TYPE_NONE;
+
+	Tokenizer tokenizer(document->m_data + offset, document->m_length - offset);
+
+	switch (tokenizer.readType()) {
+
+		case 's': m_type = Mixed::TYPE_STRING; break;
+		case 'i': m_type = Mixed::TYPE_INT; break;
+		case 'b': m_type = Mixed::TYPE_BOOL; break;
+		case 'd': m_type = Mixed::TYPE_DOUBLE; break;
+		case 'a':
+		case 'O': m_type = Mixed::TYPE_ARRAY; break;
+		default: m_type = Mixed::TYPE_NULL; break;
+	}
+}
+
+
+const char *LazyValue::data() const {
+
+	return m_document->m_data + m_offset;
+}
+
+
+void LazyValue::checkType(const Mixed::Type type, const char *name) const {
+
+	if (m_type != type) {
+		throw std::runtime_error(
+			(boost::format("Invalid value type for '%1%'.") % name).str()
+		);
+	}
+}
+
+
+Mixed::Type LazyValue::type() const {
+	return m_type;
+}
+
+
+bool LazyValue::isNull() const {
+	return m_type == Mixed::TYPE_NULL;
+}
+
+
+void LazyValue::readString(const char *&str, std::size_t &length) const {
+
+	Tokenizer tokenizer(data(), m_document->m_length - m_offset);
+	tokenizer.readType();
+
+	tokenizer.readString(str, length);
+}
+
+
+const char *LazyValue::stringData() const {
+
+	checkType(Mixed::TYPE_STRING, "string");
+
+	const char *str;
+	std::size_t length;
+
+	readString(str, length);
+
+	return str;
+}
+
+
+std::size_t LazyValue::stringLength() const {
+
+	checkType(Mixed::TYPE_STRING, "string");
+
+	const char *str;
+	std::size_t length;
+
+	readString(str, length);
+
+	return length;
+}
+
+
+std::string LazyValue::stringValue() const {
+
+	checkType(Mixed::TYPE_STRING, "string");
+
+	const char *str;
+	std::size_t length;
+
+	readString(str, length);
+
+	return std::string(str, length);
+}
+
+
+std::int64_t LazyValue::intValue() const {
+
+	checkType(Mixed::TYPE_INT, "int");
+
+	Tokenizer tokenizer(data(), m_document->m_length - m_offset);
+	tokenizer.readType();
+
+	return tokenizer.readInt();
+}
+
+
+bool LazyValue::boolValue() const {
+
+	checkType(Mixed::TYPE_BOOL, "bool");
+
+	Tokenizer tokenizer(data(), m_document->m_length - m_offset);
+	tokenizer.readType();
+
+	return tokenizer.readBool();
+}
+
+
+double LazyValue::doubleValue() const {
+
+	checkType(Mixed::TYPE_DOUBLE, "double");
+
+	Tokenizer tokenizer(data(), m_document->m_length - m_offset);
+	tokenizer.readType();
+
+	return tokenizer.readDouble();
+}
+
+
+void LazyValue::ensureElements() const {
+
+	checkType(Mixed::TYPE_ARRAY, "array");
+
+	if (m_firstElement == 0) {
+		// This value is stored in the (mutable) tape of the document
+		m_document->recordElements(const_cast <LazyValue &>(*this));
+	}
+}
+
+
+MixedArray::Type LazyValue::arrayType() const {
+
+	ensureElements();
+	return m_arrayType;
+}
+
+
+std::size_t LazyValue::size() const {
+
+	ensureElements();
+	return m_count;
+}
+
+
+const LazyValue &LazyValue::key(const std::size_t index) const {
+
+	if (index >= size()) {
+		throw std::out_of_range("Array index out of range.");
+	}
+
+	return m_document->m_tape[m_firstElement + index * 2];
+}
+
+
+const LazyValue &LazyValue::value(const std::size_t index) const {
+
+	if (index >= size()) {
+		throw std::out_of_range("Array index out of range.");
+	}
+
+	return m_document->m_tape[m_firstElement + index * 2 + 1];
+}
+
+
+const LazyValue *LazyValue::find(const std::string &key) const {
+
+	return find(key.data(), key.length());
+}
+
+
+const LazyValue *LazyValue::find(const char *key, const std::size_t length) const {
+
+	const std::size_t count = size();
+
+	for (std::size_t i = 0 ; i < count ; ++i) {
+
+		const LazyValue &k = m_document->m_tape[m_firstElement + i * 2];
+
+		if (k.m_type != Mixed::TYPE_STRING) {
+			continue;
+		}
+
+		// The key is read once and compared in place
+		const char *str;
+		std::size_t strLength;
+
+		k.readString(str, strLength);
+
+		if (strLength == length && std::memcmp(str, key, length) == 0) {
+
+			return &m_document->m_tape[m_firstElement + i * 2 + 1];
+		}
+	}
+
+	return NULL;
+}
+
+
+const LazyValue *LazyValue::find(const std::int64_t key) const {
+
+	const std::size_t count = size();
+
+	if (m_arrayType == MixedArray::TYPE_VECTOR) {
+		return key >= 0 && static_cast <std::size_t>(key) < count
+			? &m_document->m_tape[m_firstElement + key * 2 + 1] : NULL;
+	}
+
+	for (std::size_t i = 0 ; i < count ; ++i) {
+
+		const LazyValue &k = m_document->m_tape[m_firstElement + i * 2];
+
+		if (k.m_type == Mixed::TYPE_INT && k.intValue() == key) {
+			return &m_document->m_tape[m_firstElement + i * 2 + 1];
+		}
+	}
+
+	return NULL;
+}
+
+
+Mixed LazyValue::toMixed() const {
+
+	if (m_document->empty()) {
+		return Mixed();
+	}
+
+	const std::size_t end = m_document->valueEnd(*this);
+
+	Unserializer un(data(), end - m_offset);
+
+	return std::move(*un.unserializeObject());
+}
+
+
+std::size_t LazyValue::offset() const {
+	return m_offset;
+}
+
+
+
+LazyDocument::LazyDocument(const std::string &data) {
+
+	m_data = data.data();
+	m_length = data.length();
+
+	init();
+}
+
+
+LazyDocument::LazyDocument(const char *data, const std::size_t length) {
+
+	m_data = data;
+	m_length = length;
+
+	init();
+}
+
+
+LazyDocument::LazyDocument(const shared_ptr <MappedFile> &file)
+	: m_file(file) {
+
+	m_data = file->data();
+	m_length = file->length();
+
+	init();
+}
+
+
+void LazyDocument::init() {
+
+	m_tape.push_back(LazyValue(this, 0));
+}
+
+
+bool LazyDocument::empty() const {
+
+	return m_length == 0;
+}
+
+
+const LazyValue &LazyDocument::root() const {
+
+	return m_tape.front();
+}
+
+
+std::size_t LazyDocument::valueEnd(const LazyValue &value) const {
+
+	if (value.m_end == 0) {
+
+		Tokenizer tokenizer(m_data + value.m_offset, m_length - value.m_offset);
+		tokenizer.skipValue();
+
+		const_cast <LazyValue &>(value).m_end = value.m_offset + tokenizer.position();
+	}
+
+	return value.m_end;
+}
+
+
+void LazyDocument::recordElements(LazyValue &value) const {
+
+	Tokenizer tokenizer(m_data + value.m_offset, m_length - value.m_offset);
+
+	std::size_t count;
+
+	if (tokenizer.readType() == 'O') {
+
+		const char *className;
+		std::size_t classNameLength;
+
+		count = tokenizer.readObjectBegin(className, classNameLength);
+
+	} else {
+
+		count = tokenizer.readArrayBegin();
+	}
+
+	const std::size_t firstElement = m_tape.size();
+
+	MixedArray::Type arrayType = MixedArray::TYPE_VECTOR;
+
+	try {
+
+		for (std::size_t n = 0 ; n < count ; ++n) {
+
+			tokenizer.expectElement();
+
+			// Key: integer keys are decoded to find out the array type
+			const std::size_t keyOffset = value.m_offset + tokenizer.position();
+			LazyValue key(this, keyOffset);
+
+			if (tokenizer.peek() == 'i') {
+
+				tokenizer.readType();
+
+				if (tokenizer.readInt() != static_cast <std::int64_t>(n)) {
+					arrayType = MixedArray::TYPE_MAP;
+				}
+
+			} else {
+
+				tokenizer.skipValue();
+				arrayType = MixedArray::TYPE_MAP;
+			}
+
+			key.m_end = value.m_offset + tokenizer.position();
+			m_tape.push_back(key);
+
+			// Value: skipped
+			LazyValue element(this, value.m_offset + tokenizer.position());
+
+			tokenizer.skipValue();
+
+			element.m_end = value.m_offset + tokenizer.position();
+			m_tape.push_back(element);
+		}
+
+		tokenizer.expectArrayEnd();
+
+	} catch (...) {
+
+		m_tape.erase(m_tape.begin() + firstElement, m_tape.end());
+		throw;
+	}
+
+	value.m_end = value.m_offset + tokenizer.position();
+	value.m_count = count;
+	value.m_arrayType = arrayType;
+	value.m_firstElement = firstElement;
+}
+
+
+} // namespace pherialize
@@ -0,0 +1,277 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_LAZYDOCUMENT_HPP_INCLUDED
+#define PHERIALIZE_LAZYDOCUMENT_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+#include "pherialize/export.hpp"
+
+#include "pherialize/Mixed.hpp"
+#include "pherialize/MixedArray.hpp"
+#include "pherialize/MappedFile.hpp"
+
+#include <string>
+#include <deque>
+#include <cstddef>
+
+
+namespace pherialize {
+
+
+class LazyDocument;
+
+
+/** A value of a LazyDocument. It only records where the value lies
+  * in the serialized data: scalars are decoded when read, and the
+  * elements of an array are located the first time they are accessed.
+  */
+class PHERIALIZE_EXPORT LazyValue {
+
+	friend class LazyDocument;
+
+public:
+
+	/** Returns the type of the value.
+	  *
+	  * @return value type
+	  */
+	Mixed::Type type() const;
+
+	/** Returns whether this is the null value.
+	  *
+	  * @return true if the value is null, or false otherwise
+	  */
+	bool isNull() const;
+
+	/** Returns a pointer to the characters of a string value, inside
+	  * the serialized data. The string is not NUL-terminated.
+	  *
+	  * @throw std::runtime_error if the value is not a string
+	  * @return pointer to the first character of the string
+	  */
+	const char *stringData() const;
+
+	/** Returns the length of a string value.
+	  *
+	  * @throw std::runtime_error if the value is not a string
+	  * @return length of the string, in bytes
+	  */
+	std::size_t stringLength() const;
+
+	/** Returns a copy of a string value.
+	  *
+	  * @throw std::runtime_error if the value is not a string
+	  * @return string value
+	  */
+	std::string stringValue() const;
+
+	/** Returns the value as an int.
+	  *
+	  * @throw std::runtime_error if the value is not an int
+	  * @return int value
+	  */
+	std::int64_t intValue() const;
+
+	/** Returns the value as a bool.
+	  *
+	  * @throw std::runtime_error if the value is not a bool
+	  * @return bool value
+	  */
+	bool boolValue() const;
+
+	/** Returns the value as a double.
+	  *
+	  * @throw std::runtime_error if the value is not a double
+	  * @return double value
+	  */
+	double doubleValue() const;
+
+	/** Returns the kind of array, as Unserializer would build it.
+	  *
+	  * @throw std::runtime_error if the value is not an array
+	  * @return array type
+	  */
+	MixedArray::Type arrayType() const;
+
+	/** Returns the number of elements of an array.
+	  *
+	  * @throw std::runtime_error if the value is not an array
+	  * @return number of elements
+	  */
+	std::size_t size() const;
+
+	/** Returns the key of an array element.
+	  *
+	  * @param index element index, in document order
+	  * @throw std::out_of_range if the index is out of range
+	  * @return element key
+	  */
+	const LazyValue &key(const std::size_t index) const;
+
+	/** Returns the value of an array element.
+	  *
+	  * @param index element index, in document order
+	  * @throw std::out_of_range if the index is out of range
+	  * @return element value
+	  */
+	const LazyValue &value(const std::size_t index) const;
+
+	/** Finds an array element by string key.
+	  *
+	  * @param key key to search for
+	  * @throw std::runtime_error if the value is not an array
+	  * @return element value, or NULL if there is no such key
+	  */
+	const LazyValue *find(const std::string &key) const;
+
+	/** Finds an array element by string key.
+	  *
+	  * @param key pointer to key characters
+	  * @param length length of key
+	  * @throw std::runtime_error if the value is not an array
+	  * @return element value, or NULL if there is no such key
+	  */
+	const LazyValue *find(const char *key, const std::size_t length) const;
+
+	/** Finds an array element by integer key.
+	  *
+	  * @param key key to search for
+	  * @throw std::runtime_error if the value is not an array
+	  * @return element value, or NULL if there is no such key
+	  */
+	const LazyValue *find(const std::int64_t key) const;
+
+	/** Unserializes this value and its children to a Mixed value.
+	  *
+	  * @throw std::runtime_error if a parsing error occurs
+	  * @return a Mixed value
+	  */
+	Mixed toMixed() const;
+
+	/** Returns the offset of this value in the serialized data.
+	  *
+	  * @return offset of the type tag of the value
+	  */
+	std::size_t offset() const;
+
+private:
+
+	LazyValue(const LazyDocument *document, const std::size_t offset);
+
+
+	void checkType(const Mixed::Type type, const char *name) const;
+	void ensureElements() const;
+	const char *data() const;
+	void readString(const char *&str, std::size_t &length) const;
+
+
+	const LazyDocument *m_document;
+	std::size_t m_offset;            // offset of type tag
+	std::size_t m_end;               // offset after value, or 0 if not known yet
+	std::size_t m_firstElement;      // tape index of the first key, or 0 if not recorded yet
+	std::size_t m_count;             // number of array elements, once recorded
+	Mixed::Type m_type;
+	MixedArray::Type m_arrayType;
+};
+
+
+/** Gives access to serialized data without unserializing it entirely.
+  *
+  * The document keeps a tape of the values located so far. Only the
+  * top-level value is located on construction; the elements of an array
+  * are recorded (each one is skipped over, without being decoded) the
+  * first time the array is accessed. Values are decoded, or converted
+  * to Mixed, only when they are read. Hence, reading a few values from a
+  * large array only costs a scan of the levels leading to them.
+  *
+  * The data is not copied and must remain valid for the lifetime of the
+  * document. Errors in parts of the data which are never accessed are
+  * not reported. Access to a document must be synchronized by the caller,
+  * as reading values can update the tape.
+  */
+class PHERIALIZE_EXPORT LazyDocument {
+
+	friend class LazyValue;
+
+public:
+
+	/** Constructs a new lazy document over a character string.
+	  *
+	  * @param data string containing serialized data
+	  * @throw std::runtime_error if the type of the top-level value is unknown
+	  */
+	LazyDocument(const std::string &data);
+	LazyDocument(std::string &&data) = delete;
+
+	/** Constructs a new lazy document over a buffer.
+	  *
+	  * @param data pointer to serialized data
+	  * @param length length of data, in bytes
+	  * @throw std::runtime_error if the type of the top-level value is unknown
+	  */
+	LazyDocument(const char *data, const std::size_t length);
+
+	/** Constructs a new lazy document over a mapped file. The document
+	  * shares ownership of the mapping, so that strings read from the
+	  * document point directly into the file.
+	  *
+	  * @param file mapped file containing serialized data
+	  * @throw std::runtime_error if the type of the top-level value is unknown
+	  */
+	LazyDocument(const shared_ptr <MappedFile> &file);
+
+	/** Returns whether the data is empty.
+	  *
+	  * @return true if the document is empty, or false otherwise
+	  */
+	bool empty() const;
+
+	/** Returns the top-level value of this document.
+	  *
+	  * @return root value, or a null value if the document is empty
+	  */
+	const LazyValue &root() const;
+
+private:
+
+	LazyDocument(const LazyDocument &);
+	LazyDocument &operator=(const LazyDocument &);
+
+
+	void init();
+	void recordElements(LazyValue &value) const;
+	std::size_t valueEnd(const LazyValue &value) const;
+
+
+	const char *m_data;
+	std::size_t m_length;
+
+	// Keeps the mapping alive, if constructed from a file
+	shared_ptr <MappedFile> m_file;
+
+	// Values located so far; a deque keeps references stable when growing
+	mutable std::deque <LazyValue> m_tape;
+};
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_LAZYDOCUMENT_HPP_INCLUDED
@@ -0,0 +1,159 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "pherialize/MappedFile.hpp"
+
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+
+#include <boost/format.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#	define PHERIALIZE_HAVE_MMAP 1
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#else
+#	include <fstream>
+#	include <iterator>
+#endif
+
+
+
+namespace pherialize {
+
+
+#if PHERIALIZE_HAVE_MMAP
+
+
+static std::runtime_error systemError(const char *what, const std::string &path) {
+
+	return std::runtime_error(
+		(boost::format("Cannot %1% file '%2%': %3%.") % what % path % std::strerror(errno)).str()
+	);
+}
+
+
+MappedFile::MappedFile(const std::string &path, const Access access) {
+
+	m_data = NULL;
+	m_length = 0;
+	m_mapped = false;
+
+	const int fd = ::open(path.c_str(), O_RDONLY);
+
+	if (fd < 0) {
+		throw systemError("open", path);
+	}
+
+	struct stat st;
+
+	if (::fstat(fd, &st) != 0) {
+		const std::runtime_error error = systemError("stat", path);
+		::close(fd);
+		throw error;
+	}
+
+	m_length = static_cast <std::size_t>(st.st_size);
+
+	// An empty file cannot be mapped
+	if (m_length != 0) {
+
+		void *addr = ::mmap(NULL, m_length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if (addr == MAP_FAILED) {
+			const std::runtime_error error = systemError("map", path);
+			::close(fd);
+			throw error;
+		}
+
+		::madvise(addr, m_length, access == ACCESS_RANDOM ? MADV_RANDOM : MADV_SEQUENTIAL);
+
+		m_data = static_cast <const char *>(addr);
+		m_mapped = true;
+	}
+
+	// The mapping remains valid after the file is closed
+	::close(fd);
+}
+
+
+MappedFile::~MappedFile() {
+
+	if (m_mapped) {
+		::munmap(const_cast <char *>(m_data), m_length);
+	}
+}
+
+
+#else // !PHERIALIZE_HAVE_MMAP
+
+
+MappedFile::MappedFile(const std::string &path, const Access /* access */) {
+
+	m_data = NULL;
+	m_length = 0;
+	m_mapped = false;
+
+	std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+
+	if (!file) {
+		throw std::runtime_error(
+			(boost::format("Cannot open file '%1%'.") % path).str()
+		);
+	}
+
+	file.seekg(0, std::ios::end);
+	m_length = static_cast <std::size_t>(file.tellg());
+	file.seekg(0, std::ios::beg);
+
+	char *data = new char[m_length ? m_length : 1];
+
+	if (!file.read(data, m_length)) {
+		delete [] data;
+		throw std::runtime_error(
+			(boost::format("Cannot read file '%1%'.") % path).str()
+		);
+	}
+
+	m_data = data;
+}
+
+
+MappedFile::~MappedFile() {
+
+	delete [] m_data;
+}
+
+
+#endif // PHERIALIZE_HAVE_MMAP
+
+
+const char *MappedFile::data() const {
+	return m_data;
+}
+
+
+std::size_t MappedFile::length() const {
+	return m_length;
+}
+
+
+} // namespace pherialize
@@ -0,0 +1,87 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_MAPPEDFILE_HPP_INCLUDED
+#define PHERIALIZE_MAPPEDFILE_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+#include "pherialize/export.hpp"
+
+#include <string>
+#include <cstddef>
+
+
+namespace pherialize {
+
+
+/** A file mapped read-only into memory, so that it can be parsed
+  * without being read into a buffer first.
+  *
+  * On platforms without memory mapping, the file is read into memory.
+  */
+class PHERIALIZE_EXPORT MappedFile {
+
+public:
+
+	/** Expected access pattern, passed as a hint to the system.
+	  */
+	enum Access {
+		ACCESS_SEQUENTIAL,   /**< File is read from start to end (eg. Unserializer). */
+		ACCESS_RANDOM        /**< File is read in no particular order (eg. LazyDocument). */
+	};
+
+
+	/** Maps a file into memory.
+	  *
+	  * @param path path of the file
+	  * @param access expected access pattern
+	  * @throw std::runtime_error if the file cannot be opened or mapped
+	  */
+	MappedFile(const std::string &path, const Access access = ACCESS_SEQUENTIAL);
+
+	~MappedFile();
+
+	/** Returns the contents of the file.
+	  *
+	  * @return pointer to the first byte of the file
+	  */
+	const char *data() const;
+
+	/** Returns the size of the file.
+	  *
+	  * @return size in bytes
+	  */
+	std::size_t length() const;
+
+private:
+
+	MappedFile(const MappedFile &);
+	MappedFile &operator=(const MappedFile &);
+
+
+	const char *m_data;
+	std::size_t m_length;
+	bool m_mapped;
+};
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_MAPPEDFILE_HPP_INCLUDED
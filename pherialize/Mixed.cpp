@@ -17,6 +17,10 @@
 //
 
 #include "pherialize/Mixed.hpp"
+#include "pherialize/KeyDictionary.hpp"
+
+#include <new>
+#include <utility>
 
 
 
@@ -32,14 +36,34 @@ Mixed::Mixed() {
 Mixed::Mixed(const std::string &v) {
 
 	m_type = TYPE_STRING;
-	m_value.stringValue = new std::string(v);
+	m_interned = false;
+	new (&m_value.stringValue) std::string(v);
+}
+
+
+Mixed::Mixed(std::string &&v) {
+
+	m_type = TYPE_STRING;
+	m_interned = false;
+	new (&m_value.stringValue) std::string(std::move(v));
 }
 
 
 Mixed::Mixed(const char *v) {
 
 	m_type = TYPE_STRING;
-	m_value.stringValue = new std::string(v);
+	m_interned = false;
+	new (&m_value.stringValue) std::string(v);
+}
+
+
+Mixed::Mixed(InternedString *v) {
+
+	m_type = TYPE_STRING;
+	m_interned = true;
+	m_value.internedValue = v;
+
+	v->acquire();
 }
 
 
@@ -50,6 +74,20 @@ Mixed::Mixed(const int v) {
 }
 
 
+Mixed::Mixed(const long v) {
+
+	m_type = TYPE_INT;
+	m_value.intValue = v;
+}
+
+
+Mixed::Mixed(const long long v) {
+
+	m_type = TYPE_INT;
+	m_value.intValue = v;
+}
+
+
 Mixed::Mixed(const bool v) {
 
 	m_type = TYPE_BOOL;
@@ -71,15 +109,28 @@ Mixed::Mixed(const MixedArray &v) {
 }
 
 
+Mixed::Mixed(MixedArray &&v) {
+
+	m_type = TYPE_ARRAY;
+	m_value.arrayValue = new MixedArray(std::move(v));
+}
+
+
 Mixed::Mixed(const Mixed &v) {
 
 	copyValue(v);
 }
 
 
+Mixed::Mixed(Mixed &&v) noexcept {
+
+	moveValue(v);
+}
+
+
 Mixed::~Mixed() {
 
-	deleteValue(m_type, m_value);
+	deleteValue();
 }
 
 
@@ -90,7 +141,15 @@ void Mixed::copyValue(const Mixed &v) {
 	switch (m_type) {
 		case TYPE_STRING:
 
-			m_value.stringValue = new std::string(*v.m_value.stringValue);
+			m_interned = v.m_interned;
+
+			if (m_interned) {
+				m_value.internedValue = v.m_value.internedValue;
+				m_value.internedValue->acquire();
+			} else {
+				new (&m_value.stringValue) std::string(v.m_value.stringValue);
+			}
+
 			break;
 
 		case TYPE_ARRAY:
@@ -120,17 +179,69 @@ void Mixed::copyValue(const Mixed &v) {
 }
 
 
-void Mixed::deleteValue(const Type type, ValueType &value) {
+void Mixed::moveValue(Mixed &v) noexcept {
+
+	m_type = v.m_type;
 
-	switch (type) {
+	switch (m_type) {
 		case TYPE_STRING:
 
-			delete value.stringValue;
+			m_interned = v.m_interned;
+
+			if (m_interned) {
+				m_value.internedValue = v.m_value.internedValue;
+			} else {
+				new (&m_value.stringValue) std::string(std::move(v.m_value.stringValue));
+				v.m_value.stringValue.~basic_string();
+			}
+
 			break;
 
 		case TYPE_ARRAY:
 
-			delete value.arrayValue;
+			m_value.arrayValue = v.m_value.arrayValue;
+			break;
+
+		case TYPE_INT:
+
+			m_value.intValue = v.m_value.intValue;
+			break;
+
+		case TYPE_BOOL:
+
+			m_value.boolValue = v.m_value.boolValue;
+			break;
+
+		case TYPE_DOUBLE:
+
+			m_value.doubleValue = v.m_value.doubleValue;
+			break;
+
+		case TYPE_NULL:
+
+			break;
+	}
+
+	v.m_type = TYPE_NULL;
+}
+
+
+void Mixed::deleteValue() noexcept {
+
+	switch (m_type) {
+		case TYPE_STRING:
+
+			if (m_interned) {
+				m_value.internedValue->release();
+			} else {
+				m_value.stringValue.~basic_string();
+			}
+
+			break;
+
+		case TYPE_ARRAY:
+
+			delete m_value.arrayValue;
 			break;
 
 		case TYPE_NULL:
@@ -140,16 +251,33 @@ void Mixed::deleteValue(const Type type, ValueType &value) {
 
 			break;
 	}
+
+	m_type = TYPE_NULL;
 }
 
 
 Mixed &Mixed::operator=(const Mixed &v) {
 
-	const Type oldType = m_type;
-	ValueType oldValue = m_value;
+	if (this != &v) {
 
-	copyValue(v);
-	deleteValue(oldType, oldValue);
+		// Copy first, as 'v' may be owned by this value
+		Mixed copy(v);
+		*this = std::move(copy);
+	}
+
+	return *this;
+}
+
+
+Mixed &Mixed::operator=(Mixed &&v) noexcept {
+
+	if (this != &v) {
+
+		// Keep the old value alive until 'v' has been moved from,
+		// as 'v' may be owned by it
+		Mixed old(std::move(*this));
+		moveValue(v);
+	}
 
 	return *this;
 }
@@ -164,7 +292,18 @@ bool Mixed::operator==(const Mixed &v) const {
 	switch (m_type) {
 		case TYPE_STRING:
 
-			return *m_value.stringValue == *v.m_value.stringValue;
+			// Interned strings of the same dictionary are equal only if
+			// they are the same object
+			if (m_interned && v.m_interned) {
+
+				if (m_value.internedValue == v.m_value.internedValue) {
+					return true;
+				} else if (m_value.internedValue->m_dictionaryId == v.m_value.internedValue->m_dictionaryId) {
+					return false;
+				}
+			}
+
+			return stringValue() == v.stringValue();
 
 		case TYPE_ARRAY:
 
@@ -206,7 +345,11 @@ bool Mixed::operator<(const Mixed &v) const {
 	switch (m_type) {
 		case TYPE_STRING:
 
-			return *m_value.stringValue < *v.m_value.stringValue;
+			if (m_interned && v.m_interned && m_value.internedValue == v.m_value.internedValue) {
+				return false;
+			}
+
+			return stringValue() < v.stringValue();
 
 		case TYPE_ARRAY:
 
@@ -245,11 +388,11 @@ const std::string &Mixed::stringValue() const {
 	if (m_type != TYPE_STRING) {
 		throw std::runtime_error("Invalid value type for 'string'.");
 	}
-	return *m_value.stringValue;
+	return m_interned ? m_value.internedValue->value() : m_value.stringValue;
 }
 
 
-int Mixed::intValue() const {
+std::int64_t Mixed::intValue() const {
 	if (m_type != TYPE_INT) {
 		throw std::runtime_error("Invalid value type for 'int'.");
 	}
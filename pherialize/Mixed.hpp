@@ -27,11 +27,15 @@
 
 #include <string>
 #include <stdexcept>
+#include <cstdint>
 
 
 namespace pherialize {
 
 
+class InternedString;
+
+
 /** A mixed value (variant), as in PHP.
   */
 class PHERIALIZE_EXPORT Mixed {
@@ -52,13 +56,18 @@ public:
 
 	Mixed();
 	Mixed(const std::string &v);
+	Mixed(std::string &&v);
 	Mixed(const char *v);
 	Mixed(const int v);
+	Mixed(const long v);
+	Mixed(const long long v);
 	Mixed(const bool v);
 	Mixed(const double v);
 	Mixed(const MixedArray &v);
+	Mixed(MixedArray &&v);
 
 	Mixed(const Mixed &v);
+	Mixed(Mixed &&v) noexcept;
 
 	~Mixed();
 
@@ -80,12 +89,13 @@ public:
 	  */
 	const std::string &stringValue() const;
 
-	/** Returns the value as an int.
+	/** Returns the value as an int. Integers are stored on 64 bits,
+	  * as in PHP on 64-bit platforms.
 	  *
 	  * @throw std::runtime_error if the stored value is not an int
 	  * @return int value
 	  */
-	int intValue() const;
+	std::int64_t intValue() const;
 
 	/** Returns the value as a bool.
 	  *
@@ -109,15 +119,31 @@ public:
 	const MixedArray &arrayValue() const;
 
 	Mixed &operator=(const Mixed &v);
+	Mixed &operator=(Mixed &&v) noexcept;
 	bool operator==(const Mixed &v) const;
 	bool operator!=(const Mixed &v) const;
 	bool operator<(const Mixed &v) const;
 
 private:
 
+	friend class KeyDictionary;
+
+	Mixed(InternedString *v);
+
+
+	/** Strings are stored inline rather than through a separately
+	  * allocated std::string, so that short strings (which fit in
+	  * the small string buffer of std::string) need no allocation.
+	  * The active member is constructed and destroyed explicitly.
+	  * Strings from a KeyDictionary are shared instead.
+	  */
 	union ValueType {
-		std::string *stringValue;
-		int intValue;
+		ValueType() { }
+		~ValueType() { }
+
+		std::string stringValue;
+		InternedString *internedValue;
+		std::int64_t intValue;
 		bool boolValue;
 		double doubleValue;
 		MixedArray *arrayValue;
@@ -125,10 +151,12 @@ private:
 
 
 	void copyValue(const Mixed &v);
-	void deleteValue(const Type type, ValueType &value);
+	void moveValue(Mixed &v) noexcept;
+	void deleteValue() noexcept;
 
 
 	Type m_type;
+	bool m_interned;    // for strings: whether internedValue is used
 	ValueType m_value;
 };
 
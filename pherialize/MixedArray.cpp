@@ -19,11 +19,230 @@
 #include "pherialize/MixedArray.hpp"
 #include "pherialize/Mixed.hpp"
 
+#include <utility>
+#include <cstring>
+#include <cstdint>
+#include <atomic>
+
 
 
 namespace pherialize {
 
 
+/** Storage for TYPE_MAP: entries are stored contiguously, in insertion
+  * order, and indexed by an open addressing hash table. A sorted std::map
+  * view is only built if requested through mapValue().
+  */
+struct MixedArray::MapValue {
+
+	struct Slot {
+		std::uint32_t hash;    // low bits of the hash of the key
+		std::uint32_t index;   // entry index + 1, or 0 if the slot is empty
+	};
+
+
+	MapValue(std::vector <Entry> &&v)
+		: entries(std::move(v)), view(NULL) {
+
+		buildIndex();
+	}
+
+	MapValue(const MapValue &v)
+		: entries(v.entries), slots(v.slots), view(NULL) {
+
+		// Entries are copied in the same order, so the index is still valid
+	}
+
+	~MapValue() {
+
+		delete view.load();
+	}
+
+
+	static std::size_t hash(const char *str, const std::size_t length) {
+
+		// FNV-1a
+		std::uint64_t h = 14695981039346656037ULL;
+
+		for (std::size_t i = 0 ; i < length ; ++i) {
+			h ^= static_cast <unsigned char>(str[i]);
+			h *= 1099511628211ULL;
+		}
+
+		return static_cast <std::size_t>(h);
+	}
+
+	static std::size_t hash(const std::int64_t key) {
+
+		std::uint64_t h = static_cast <std::uint64_t>(key) * 0x9E3779B97F4A7C15ULL;
+		return static_cast <std::size_t>(h ^ (h >> 32));
+	}
+
+	static std::size_t hash(const Mixed &key) {
+
+		switch (key.type()) {
+			case Mixed::TYPE_STRING:
+
+				return hash(key.stringValue().data(), key.stringValue().length());
+
+			case Mixed::TYPE_INT:
+
+				return hash(key.intValue());
+
+			case Mixed::TYPE_BOOL:
+
+				return hash(static_cast <std::int64_t>(key.boolValue()) + 1);
+
+			case Mixed::TYPE_DOUBLE: {
+
+				// 0.0 and -0.0 compare equal
+				const double d = key.doubleValue() == 0 ? 0.0 : key.doubleValue();
+				std::uint64_t bits;
+
+				std::memcpy(&bits, &d, sizeof(bits));
+
+				return hash(static_cast <std::int64_t>(bits));
+			}
+			case Mixed::TYPE_NULL:
+			case Mixed::TYPE_ARRAY:
+
+				break;
+		}
+
+		return 0;
+	}
+
+
+	/** Builds the index over the entries. Entries whose key is
+	  * a duplicate of a previous one are removed.
+	  */
+	void buildIndex() {
+
+		if (entries.empty()) {
+			return;
+		}
+
+		// Keep the load factor at or below 1/2
+		std::size_t size = 8;
+
+		while (size < entries.size() * 2) {
+			size *= 2;
+		}
+
+		const Slot empty = { 0, 0 };
+		slots.assign(size, empty);
+
+		std::size_t count = 0;
+
+		for (std::size_t i = 0 ; i < entries.size() ; ++i) {
+
+			const Mixed &key = entries[i].first;
+			const std::uint32_t h = static_cast <std::uint32_t>(hash(key));
+
+			std::size_t slot = h & (size - 1);
+			bool duplicate = false;
+
+			for ( ; slots[slot].index != 0 ; slot = (slot + 1) & (size - 1)) {
+
+				if (slots[slot].hash == h && entries[slots[slot].index - 1].first == key) {
+					duplicate = true;
+					break;
+				}
+			}
+
+			if (duplicate) {
+				continue;
+			}
+
+			if (count != i) {
+				entries[count] = std::move(entries[i]);
+			}
+
+			slots[slot].hash = h;
+			slots[slot].index = static_cast <std::uint32_t>(++count);
+		}
+
+		entries.erase(entries.begin() + count, entries.end());
+	}
+
+
+	template <typename Match>
+	const Mixed *lookup(const std::size_t fullHash, const Match &match) const {
+
+		if (slots.empty()) {
+			return NULL;
+		}
+
+		const std::uint32_t h = static_cast <std::uint32_t>(fullHash);
+		const std::size_t mask = slots.size() - 1;
+
+		for (std::size_t slot = h & mask ; slots[slot].index != 0 ; slot = (slot + 1) & mask) {
+
+			if (slots[slot].hash == h) {
+
+				const Entry &entry = entries[slots[slot].index - 1];
+
+				if (match(entry.first)) {
+					return &entry.second;
+				}
+			}
+		}
+
+		return NULL;
+	}
+
+	const Mixed *find(const char *key, const std::size_t length) const {
+
+		return lookup(hash(key, length), [key, length](const Mixed &k) {
+			return k.type() == Mixed::TYPE_STRING &&
+			       k.stringValue().length() == length &&
+			       std::memcmp(k.stringValue().data(), key, length) == 0;
+		});
+	}
+
+	const Mixed *find(const std::int64_t key) const {
+
+		return lookup(hash(key), [key](const Mixed &k) {
+			return k.type() == Mixed::TYPE_INT && k.intValue() == key;
+		});
+	}
+
+	const Mixed *find(const Mixed &key) const {
+
+		return lookup(hash(key), [&key](const Mixed &k) {
+			return k == key;
+		});
+	}
+
+
+	const std::map <Mixed, Mixed> &sortedView() const {
+
+		std::map <Mixed, Mixed> *map = view.load(std::memory_order_acquire);
+
+		if (map == NULL) {
+
+			// Concurrent readers may build the view at the same time:
+			// only the first one to finish publishes it
+			std::map <Mixed, Mixed> *built = new std::map <Mixed, Mixed>(entries.begin(), entries.end());
+
+			if (view.compare_exchange_strong(map, built, std::memory_order_acq_rel)) {
+				map = built;
+			} else {
+				delete built;
+			}
+		}
+
+		return *map;
+	}
+
+
+	std::vector <Entry> entries;
+	std::vector <Slot> slots;
+
+	mutable std::atomic <std::map <Mixed, Mixed> *> view;
+};
+
+
 MixedArray::MixedArray() {
 
 	m_type = TYPE_NONE;
@@ -40,7 +259,56 @@ MixedArray::MixedArray(const std::vector <Mixed> &v) {
 MixedArray::MixedArray(const std::map <Mixed, Mixed> &v) {
 
 	m_type = TYPE_MAP;
-	m_value.map = new std::map <Mixed, Mixed>(v);
+	m_value.map = new MapValue(std::vector <Entry>(v.begin(), v.end()));
+}
+
+
+MixedArray::MixedArray(const std::vector <Entry> &v) {
+
+	m_type = TYPE_MAP;
+	m_value.map = new MapValue(std::vector <Entry>(v));
+}
+
+
+MixedArray::MixedArray(std::vector <Mixed> &&v) {
+
+	m_type = TYPE_VECTOR;
+	m_value.vector = new std::vector <Mixed>(std::move(v));
+}
+
+
+MixedArray::MixedArray(std::map <Mixed, Mixed> &&v) {
+
+	std::vector <Entry> entries;
+	entries.reserve(v.size());
+
+	for (std::map <Mixed, Mixed>::iterator it = v.begin() ; it != v.end() ; ++it) {
+		entries.emplace_back(it->first, std::move(it->second));
+	}
+
+	v.clear();
+
+	m_type = TYPE_MAP;
+	m_value.map = new MapValue(std::move(entries));
+}
+
+
+MixedArray::MixedArray(std::vector <Entry> &&v) {
+
+	m_type = TYPE_MAP;
+	m_value.map = new MapValue(std::move(v));
+}
+
+
+void MixedArray::convertToEntries(std::vector <Mixed> &vector, std::vector <Entry> &entries) {
+
+	entries.reserve(vector.capacity());
+
+	for (std::size_t i = 0 ; i < vector.size() ; ++i) {
+		entries.emplace_back(Mixed(static_cast <std::int64_t>(i)), std::move(vector[i]));
+	}
+
+	std::vector <Mixed>().swap(vector);
 }
 
 
@@ -56,28 +324,75 @@ MixedArray::MixedArray(const MixedArray &v) {
 
 		case TYPE_MAP:
 
-			m_value.map = new std::map <Mixed, Mixed>(*v.m_value.map);
+			m_value.map = new MapValue(*v.m_value.map);
 			break;
 	}
 }
 
 
+MixedArray::MixedArray(MixedArray &&v) noexcept {
+
+	m_type = v.m_type;
+	m_value = v.m_value;
+
+	v.m_type = TYPE_NONE;
+}
+
+
 MixedArray::~MixedArray() {
 
-	switch (m_type) {
+	deleteValue(m_type, m_value);
+}
+
+
+void MixedArray::deleteValue(const Type type, ValueType &value) {
+
+	switch (type) {
 		case TYPE_VECTOR:
 
-			delete m_value.vector;
+			delete value.vector;
 			break;
 
 		case TYPE_MAP:
 
-			delete m_value.map;
+			delete value.map;
+			break;
+
+		case TYPE_NONE:
+
 			break;
 	}
 }
 
 
+MixedArray &MixedArray::operator=(const MixedArray &v) {
+
+	MixedArray copy(v);
+	*this = std::move(copy);
+
+	return *this;
+}
+
+
+MixedArray &MixedArray::operator=(MixedArray &&v) noexcept {
+
+	if (this != &v) {
+
+		const Type oldType = m_type;
+		ValueType oldValue = m_value;
+
+		m_type = v.m_type;
+		m_value = v.m_value;
+
+		v.m_type = TYPE_NONE;
+
+		deleteValue(oldType, oldValue);
+	}
+
+	return *this;
+}
+
+
 bool MixedArray::operator==(const MixedArray &v) const {
 
 	if (m_type != v.m_type) {
@@ -93,9 +408,26 @@ bool MixedArray::operator==(const MixedArray &v) const {
 
 			return *m_value.vector == *v.m_value.vector;
 
-		case TYPE_MAP:
+		case TYPE_MAP: {
+
+			// As in PHP, the order of elements does not matter
+			const std::vector <Entry> &entries = m_value.map->entries;
+
+			if (entries.size() != v.m_value.map->entries.size()) {
+				return false;
+			}
 
-			return *m_value.map == *v.m_value.map;
+			for (std::size_t i = 0 ; i < entries.size() ; ++i) {
+
+				const Mixed *value = v.m_value.map->find(entries[i].first);
+
+				if (value == NULL || *value != entries[i].second) {
+					return false;
+				}
+			}
+
+			return true;
+		}
 	}
 
 	return false;
@@ -111,6 +443,26 @@ MixedArray::Type MixedArray::type() const {
 }
 
 
+std::size_t MixedArray::size() const {
+
+	switch (m_type) {
+		case TYPE_VECTOR:
+
+			return m_value.vector->size();
+
+		case TYPE_MAP:
+
+			return m_value.map->entries.size();
+
+		case TYPE_NONE:
+
+			break;
+	}
+
+	return 0;
+}
+
+
 const std::vector <Mixed> &MixedArray::vectorValue() const {
 	if (m_type != TYPE_VECTOR) {
 		throw std::runtime_error("Invalid value type for 'vector'.");
@@ -123,7 +475,91 @@ const std::map <Mixed, Mixed> &MixedArray::mapValue() const {
 	if (m_type != TYPE_MAP) {
 		throw std::runtime_error("Invalid value type for 'map'.");
 	}
-	return *m_value.map;
+	return m_value.map->sortedView();
+}
+
+
+const std::vector <MixedArray::Entry> &MixedArray::entries() const {
+	if (m_type != TYPE_MAP) {
+		throw std::runtime_error("Invalid value type for 'map'.");
+	}
+	return m_value.map->entries;
+}
+
+
+const Mixed *MixedArray::find(const std::string &key) const {
+
+	return find(key.data(), key.length());
+}
+
+
+const Mixed *MixedArray::find(const char *key) const {
+
+	return find(key, std::strlen(key));
+}
+
+
+const Mixed *MixedArray::find(const char *key, const std::size_t length) const {
+
+	if (m_type != TYPE_MAP) {
+		return NULL;
+	}
+
+	return m_value.map->find(key, length);
+}
+
+
+const Mixed *MixedArray::find(const int key) const {
+
+	return find(static_cast <std::int64_t>(key));
+}
+
+
+const Mixed *MixedArray::find(const std::int64_t key) const {
+
+	switch (m_type) {
+		case TYPE_VECTOR:
+
+			if (key < 0 || static_cast <std::size_t>(key) >= m_value.vector->size()) {
+				return NULL;
+			}
+
+			return &(*m_value.vector)[key];
+
+		case TYPE_MAP:
+
+			return m_value.map->find(key);
+
+		case TYPE_NONE:
+
+			break;
+	}
+
+	return NULL;
+}
+
+
+const Mixed *MixedArray::find(const Mixed &key) const {
+
+	switch (key.type()) {
+		case Mixed::TYPE_STRING:
+
+			return find(key.stringValue());
+
+		case Mixed::TYPE_INT:
+
+			return find(key.intValue());
+
+		default:
+
+			break;
+	}
+
+	if (m_type != TYPE_MAP) {
+		return NULL;
+	}
+
+	return m_value.map->find(key);
 }
 
 
@@ -25,7 +25,11 @@
 
 #include <vector>
 #include <map>
+#include <string>
+#include <utility>
 #include <stdexcept>
+#include <cstddef>
+#include <cstdint>
 
 
 namespace pherialize {
@@ -35,6 +39,11 @@ class Mixed;
 
 
 /** An array or map containing mixed values.
+  *
+  * As PHP arrays, maps preserve the insertion order of their elements:
+  * they are stored contiguously as key/value entries, and indexed by
+  * a hash table built when the map is constructed, so that keys can
+  * be looked up with find() in constant time.
   */
 class PHERIALIZE_EXPORT MixedArray {
 
@@ -48,12 +57,27 @@ public:
 		TYPE_MAP,
 	};
 
+	/** A key/value element of a map.
+	  */
+	typedef std::pair <Mixed, Mixed> Entry;
+
 
 	MixedArray();
 	MixedArray(const std::vector <Mixed> &v);
 	MixedArray(const std::map <Mixed, Mixed> &v);
+	MixedArray(std::vector <Mixed> &&v);
+	MixedArray(std::map <Mixed, Mixed> &&v);
+
+	/** Constructs a map from key/value entries, keeping their order.
+	  * If a key appears more than once, only its first entry is kept.
+	  *
+	  * @param v entries of the map
+	  */
+	MixedArray(const std::vector <Entry> &v);
+	MixedArray(std::vector <Entry> &&v);
 
 	MixedArray(const MixedArray &v);
+	MixedArray(MixedArray &&v) noexcept;
 
 	~MixedArray();
 
@@ -64,6 +88,13 @@ public:
 	  */
 	Type type() const;
 
+	/** Returns the number of elements.
+	  *
+	  * @return number of elements in the vector or map, or 0 if
+	  * there is no value
+	  */
+	std::size_t size() const;
+
 	/** Returns the value as a vector.
 	  *
 	  * @throw std::runtime_error if the stored value is not a vector
@@ -71,27 +102,96 @@ public:
 	  */
 	const std::vector <Mixed> &vectorValue() const;
 
-	/** Returns the value as a map.
+	/** Returns the value as a map, sorted by key. The sorted map is
+	  * built the first time it is requested; prefer entries() to
+	  * iterate over elements.
 	  *
 	  * @throw std::runtime_error if the stored value is not a map
 	  * @return map value
 	  */
 	const std::map <Mixed, Mixed> &mapValue() const;
 
+	/** Returns the elements of a map, in insertion order.
+	  *
+	  * @throw std::runtime_error if the stored value is not a map
+	  * @return map entries
+	  */
+	const std::vector <Entry> &entries() const;
+
+	/** Finds an element by string key, without constructing
+	  * a Mixed value for the key.
+	  *
+	  * @param key key to search for
+	  * @return element value, or NULL if there is no such key
+	  */
+	const Mixed *find(const std::string &key) const;
+
+	/** Finds an element by string key, without constructing
+	  * a Mixed value for the key.
+	  *
+	  * @param key NUL-terminated key to search for
+	  * @return element value, or NULL if there is no such key
+	  */
+	const Mixed *find(const char *key) const;
+
+	/** Finds an element by string key, without constructing
+	  * a Mixed value for the key.
+	  *
+	  * @param key pointer to key characters
+	  * @param length length of key, in bytes
+	  * @return element value, or NULL if there is no such key
+	  */
+	const Mixed *find(const char *key, const std::size_t length) const;
 
+	/** Finds an element by integer key. For a vector, this is
+	  * the element at the given index.
+	  *
+	  * @param key key to search for
+	  * @return element value, or NULL if there is no such key
+	  */
+	const Mixed *find(const std::int64_t key) const;
+	const Mixed *find(const int key) const;
+
+	/** Finds an element by key.
+	  *
+	  * @param key key to search for
+	  * @return element value, or NULL if there is no such key
+	  */
+	const Mixed *find(const Mixed &key) const;
+
+	/** Converts the elements of a vector to map entries, with keys
+	  * from 0 to n-1. This is used when building an array in a single
+	  * pass: elements are stored in a vector as long as keys are
+	  * consecutive integers starting from 0, and the first other key
+	  * converts them to entries, to which the remaining ones are appended.
+	  * Entries get the capacity reserved for the vector, and the memory
+	  * of the vector is released.
+	  *
+	  * @param vector elements read so far
+	  * @param entries empty vector to receive the entries
+	  */
+	static void convertToEntries(std::vector <Mixed> &vector, std::vector <Entry> &entries);
+
+
+	MixedArray &operator=(const MixedArray &v);
+	MixedArray &operator=(MixedArray &&v) noexcept;
 	bool operator==(const MixedArray &v) const;
 	bool operator!=(const MixedArray &v) const;
 
 private:
 
-	MixedArray &operator=(const MixedArray &v);
+	struct MapValue;
 
 
 	union ValueType {
 		std::vector <Mixed> *vector;
-		std::map <Mixed, Mixed> *map;
+		MapValue *map;
 	};
 
+
+	void deleteValue(const Type type, ValueType &value);
+
+
 	Type m_type;
 	ValueType m_value;
 };
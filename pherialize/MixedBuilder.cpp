@@ -0,0 +1,162 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "pherialize/MixedBuilder.hpp"
+
+#include <string>
+#include <utility>
+#include <algorithm>
+
+
+
+namespace pherialize {
+
+
+// Element counts may come from data which has not been checked yet
+// (eg. with StreamUnserializer), so memory reserved from them is capped
+static const std::size_t MAX_RESERVED_ELEMENTS = 4096;
+
+
+MixedBuilder::MixedBuilder() {
+
+}
+
+
+bool MixedBuilder::hasValue() const {
+
+	return !m_values.empty();
+}
+
+
+shared_ptr <Mixed> MixedBuilder::takeValue() {
+
+	if (m_values.empty()) {
+		return shared_ptr <Mixed>();
+	}
+
+	shared_ptr <Mixed> value = make_shared <Mixed>(std::move(m_values.front()));
+	m_values.pop_front();
+
+	return value;
+}
+
+
+void MixedBuilder::addValue(Mixed &&value) {
+
+	if (m_frames.empty()) {
+		m_values.push_back(std::move(value));
+		return;
+	}
+
+	Frame &frame = m_frames.back();
+
+	if (frame.expectingKey) {
+		frame.key = std::move(value);
+		frame.expectingKey = false;
+		return;
+	}
+
+	// Same as Unserializer: use a vector as long as keys are consecutive
+	// integers starting from 0, then convert to map entries
+	if (frame.isVector) {
+
+		if (frame.key.type() == Mixed::TYPE_INT &&
+		    frame.key.intValue() == static_cast <std::int64_t>(frame.vector.size())) {
+
+			frame.vector.push_back(std::move(value));
+			return;
+		}
+
+		MixedArray::convertToEntries(frame.vector, frame.entries);
+		frame.isVector = false;
+	}
+
+	frame.entries.emplace_back(std::move(frame.key), std::move(value));
+}
+
+
+void MixedBuilder::onNull() {
+
+	addValue(Mixed());
+}
+
+
+void MixedBuilder::onInt(const std::int64_t value) {
+
+	addValue(Mixed(value));
+}
+
+
+void MixedBuilder::onBool(const bool value) {
+
+	addValue(Mixed(value));
+}
+
+
+void MixedBuilder::onDouble(const double value) {
+
+	addValue(Mixed(value));
+}
+
+
+void MixedBuilder::onString(const char *str, const std::size_t length) {
+
+	addValue(Mixed(std::string(str, length)));
+}
+
+
+void MixedBuilder::onArrayBegin(const std::size_t count) {
+
+	m_frames.push_back(Frame());
+
+	Frame &frame = m_frames.back();
+
+	frame.vector.reserve(std::min(count, MAX_RESERVED_ELEMENTS));
+
+	frame.isVector = true;
+	frame.expectingKey = false;
+}
+
+
+void MixedBuilder::onObjectBegin(const char * /* className */, const std::size_t /* classNameLength */, const std::size_t count) {
+
+	onArrayBegin(count);
+}
+
+
+void MixedBuilder::onKey() {
+
+	m_frames.back().expectingKey = true;
+}
+
+
+void MixedBuilder::onArrayEnd() {
+
+	Frame &frame = m_frames.back();
+
+	Mixed array = frame.isVector
+		? Mixed(MixedArray(std::move(frame.vector)))
+		: Mixed(MixedArray(std::move(frame.entries)));
+
+	m_frames.pop_back();
+
+	addValue(std::move(array));
+}
+
+
+} // namespace pherialize
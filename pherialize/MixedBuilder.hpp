@@ -0,0 +1,92 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_MIXEDBUILDER_HPP_INCLUDED
+#define PHERIALIZE_MIXEDBUILDER_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+#include "pherialize/export.hpp"
+
+#include "pherialize/Mixed.hpp"
+#include "pherialize/MixedArray.hpp"
+#include "pherialize/UnserializeHandler.hpp"
+
+#include <vector>
+#include <map>
+#include <deque>
+
+
+namespace pherialize {
+
+
+/** A handler which builds Mixed values from unserialization events.
+  * Arrays are built the same way as by Unserializer. Each complete
+  * top-level value is queued until it is taken from the builder.
+  */
+class PHERIALIZE_EXPORT MixedBuilder : public UnserializeHandler {
+
+public:
+
+	MixedBuilder();
+
+	/** Returns whether a complete value can be taken from the builder.
+	  *
+	  * @return true if a value is available, or false otherwise
+	  */
+	bool hasValue() const;
+
+	/** Removes the oldest complete value from the builder.
+	  *
+	  * @return a Mixed object, or NULL if no value is available
+	  */
+	shared_ptr <Mixed> takeValue();
+
+	void onNull();
+	void onInt(const std::int64_t value);
+	void onBool(const bool value);
+	void onDouble(const double value);
+	void onString(const char *str, const std::size_t length);
+	void onArrayBegin(const std::size_t count);
+	void onObjectBegin(const char *className, const std::size_t classNameLength, const std::size_t count);
+	void onKey();
+	void onArrayEnd();
+
+private:
+
+	struct Frame {
+		std::vector <Mixed> vector;
+		std::vector <MixedArray::Entry> entries;
+		Mixed key;
+		bool isVector;
+		bool expectingKey;
+	};
+
+
+	void addValue(Mixed &&value);
+
+
+	std::vector <Frame> m_frames;
+	std::deque <Mixed> m_values;
+};
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_MIXEDBUILDER_HPP_INCLUDED
@@ -0,0 +1,60 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "pherialize/ParseStats.hpp"
+
+
+
+namespace pherialize {
+
+
+ParseStats::ParseStats() {
+
+	reset();
+}
+
+
+void ParseStats::reset() {
+
+	bytes = 0;
+
+	for (std::size_t i = 0 ; i <= Mixed::TYPE_ARRAY ; ++i) {
+		nodes[i] = 0;
+	}
+
+	maxDepth = 0;
+	allocations = 0;
+	allocatedBytes = 0;
+	parseSeconds = 0;
+	indexSeconds = 0;
+}
+
+
+std::size_t ParseStats::totalNodes() const {
+
+	std::size_t total = 0;
+
+	for (std::size_t i = 0 ; i <= Mixed::TYPE_ARRAY ; ++i) {
+		total += nodes[i];
+	}
+
+	return total;
+}
+
+
+} // namespace pherialize
@@ -0,0 +1,87 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_PARSESTATS_HPP_INCLUDED
+#define PHERIALIZE_PARSESTATS_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+#include "pherialize/export.hpp"
+
+#include "pherialize/Mixed.hpp"
+
+#include <cstddef>
+
+
+namespace pherialize {
+
+
+/** Statistics on the data read by an Unserializer, to find out the
+  * shape of a payload: a few large strings, deep nesting, or many
+  * small values. See Unserializer::setStats().
+  *
+  * Counters are accumulated over all the objects read, until reset()
+  * is called. If the library is built with PHERIALIZE_DISABLE_STATS,
+  * statistics are not recorded and all the counters stay at zero.
+  */
+struct PHERIALIZE_EXPORT ParseStats {
+
+	ParseStats();
+
+	/** Resets all the counters to zero.
+	  */
+	void reset();
+
+	/** Returns the total number of values read, keys included.
+	  *
+	  * @return number of values
+	  */
+	std::size_t totalNodes() const;
+
+
+	/** Number of bytes of serialized data consumed. */
+	std::size_t bytes;
+
+	/** Number of values read for each type (indexed by Mixed::Type),
+	  * keys included; objects are counted as arrays. */
+	std::size_t nodes[Mixed::TYPE_ARRAY + 1];
+
+	/** Maximum nesting depth of arrays (0 if no array has been read). */
+	std::size_t maxDepth;
+
+	/** Number of heap allocations made for the contents of strings
+	  * and the elements of arrays, when building Mixed values. Strings
+	  * short enough to be stored inline are not counted, nor are the
+	  * fixed-size allocations of MixedArray. */
+	std::size_t allocations;
+
+	/** Number of bytes requested by these allocations. */
+	std::size_t allocatedBytes;
+
+	/** Time spent reading objects, in seconds. */
+	double parseSeconds;
+
+	/** Part of parseSeconds spent indexing the keys of maps. */
+	double indexSeconds;
+};
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_PARSESTATS_HPP_INCLUDED
@@ -0,0 +1,388 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "pherialize/StreamUnserializer.hpp"
+#include "pherialize/Tokenizer.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+#include <boost/format.hpp>
+
+
+
+namespace pherialize {
+
+
+// Tokens other than string contents are short; this bounds the
+// memory used by a stream which never terminates a token
+static const std::size_t MAX_TOKEN_LENGTH = 128;
+
+
+StreamUnserializer::StreamUnserializer() {
+
+	m_handler = &m_builder;
+	m_state = STATE_TYPE;
+	m_failed = false;
+}
+
+
+StreamUnserializer::StreamUnserializer(UnserializeHandler &handler) {
+
+	m_handler = &handler;
+	m_state = STATE_TYPE;
+	m_failed = false;
+}
+
+
+void StreamUnserializer::feed(const std::string &data) {
+
+	feed(data.data(), data.length());
+}
+
+
+void StreamUnserializer::feed(const char *data, const std::size_t length) {
+
+	if (m_failed) {
+		throw std::runtime_error("Unserializer is in error state.");
+	}
+
+	try {
+
+		parse(data, length);
+
+	} catch (...) {
+
+		m_failed = true;
+		throw;
+	}
+}
+
+
+shared_ptr <Mixed> StreamUnserializer::nextObject() {
+
+	return m_builder.takeValue();
+}
+
+
+bool StreamUnserializer::isComplete() const {
+
+	return m_state == STATE_TYPE && m_frames.empty();
+}
+
+
+void StreamUnserializer::finish() {
+
+	if (!isComplete()) {
+		throw std::runtime_error("Unexpected end of data.");
+	}
+}
+
+
+void StreamUnserializer::parse(const char *data, const std::size_t length) {
+
+	const char *p = data;
+	const char *end = data + length;
+
+	while (p < end) {
+
+		switch (m_state) {
+
+			case STATE_TYPE: {
+
+				const char c = *p++;
+
+				if (!m_frames.empty() && m_frames.back().expectingKey) {
+
+					if (c == '}') {
+
+						if (m_frames.back().remaining != 0) {
+							throw std::runtime_error("Element count mismatch.");
+						}
+
+						m_frames.pop_back();
+						m_handler->onArrayEnd();
+
+						endValue();
+						break;
+					}
+
+					if (m_frames.back().remaining == 0) {
+						throw std::runtime_error("Element count mismatch.");
+					}
+
+					--m_frames.back().remaining;
+
+					m_handler->onKey();
+				}
+
+				startValue(c);
+				break;
+			}
+			case STATE_TOKEN:
+
+				while (p < end) {
+
+					const char c = *p++;
+
+					m_token += c;
+
+					if (c == m_terminator && --m_terminatorCount == 0) {
+						endToken();
+						break;
+					}
+
+					if (m_token.length() > MAX_TOKEN_LENGTH) {
+						throw std::runtime_error("Token too long.");
+					}
+				}
+
+				break;
+
+			case STATE_BYTES: {
+
+				const std::size_t needed = m_bytesLength - m_bytes.length();
+				const std::size_t available = end - p;
+
+				if (m_bytes.empty() && available >= needed) {
+
+					// Whole string is in this chunk: no copy
+					const char *bytes = p;
+					p += needed;
+
+					endBytes(bytes);
+
+				} else {
+
+					const std::size_t count = std::min(needed, available);
+
+					m_bytes.append(p, count);
+					p += count;
+
+					if (m_bytes.length() == m_bytesLength) {
+						endBytes(m_bytes.data());
+					}
+				}
+
+				break;
+			}
+		}
+	}
+}
+
+
+void StreamUnserializer::startValue(const char type) {
+
+	m_token.assign(1, type);
+
+	switch (type) {
+
+		case 'N':
+		case 'i':
+		case 'b':
+		case 'd':
+
+			startToken(TOKEN_SCALAR, ';', 1);
+			return;
+
+		case 'a':
+
+			startToken(TOKEN_ARRAY, '{', 1);
+			return;
+
+		case 's':
+
+			startToken(TOKEN_STRING_HEADER, ':', 2);
+			return;
+
+		case 'O':
+
+			startToken(TOKEN_OBJECT_HEADER, ':', 2);
+			return;
+	}
+
+	throw std::runtime_error(
+		(boost::format("Unable to unserialize unknown type '%1%'.") % type).str()
+	);
+}
+
+
+void StreamUnserializer::startToken(const TokenKind kind, const char terminator, const int terminatorCount) {
+
+	m_state = STATE_TOKEN;
+	m_tokenKind = kind;
+	m_terminator = terminator;
+	m_terminatorCount = terminatorCount;
+}
+
+
+void StreamUnserializer::endToken() {
+
+	Tokenizer tokenizer(m_token.data(), m_token.length());
+
+	switch (m_tokenKind) {
+
+		case TOKEN_SCALAR:
+
+			switch (tokenizer.readType()) {
+
+				case 'N':
+
+					tokenizer.readNull();
+					m_handler->onNull();
+					break;
+
+				case 'i':
+
+					m_handler->onInt(tokenizer.readInt());
+					break;
+
+				case 'b':
+
+					m_handler->onBool(tokenizer.readBool());
+					break;
+
+				case 'd':
+
+					m_handler->onDouble(tokenizer.readDouble());
+					break;
+			}
+
+			endValue();
+			break;
+
+		case TOKEN_ARRAY: {
+
+			tokenizer.readType();
+
+			const std::size_t count = readCount(tokenizer);
+
+			m_handler->onArrayBegin(count);
+
+			beginArray(count);
+			break;
+		}
+
+		case TOKEN_STRING_HEADER:
+		case TOKEN_OBJECT_HEADER: {
+
+			tokenizer.readType();
+			tokenizer.expect(':');
+
+			const std::int64_t length = tokenizer.readInteger();
+
+			tokenizer.expect(':');
+
+			if (length < 0) {
+				throw std::runtime_error("Invalid length.");
+			}
+
+			m_state = STATE_BYTES;
+			m_bytes.clear();
+			m_bytesLength = static_cast <std::size_t>(length) + 2;  // "..."
+
+			break;
+		}
+		case TOKEN_STRING_END:
+
+			tokenizer.expect(';');
+
+			endValue();
+			break;
+
+		case TOKEN_OBJECT_END: {
+
+			const std::size_t count = readCount(tokenizer);
+
+			m_handler->onObjectBegin(m_className.data(), m_className.length(), count);
+
+			beginArray(count);
+			break;
+		}
+	}
+}
+
+
+std::size_t StreamUnserializer::readCount(Tokenizer &tokenizer) {
+
+	// The rest of the data is not known yet, so the count cannot be
+	// checked against it as Tokenizer::readArrayBegin() does
+	tokenizer.expect(':');
+
+	const std::int64_t count = tokenizer.readInteger();
+
+	tokenizer.expect(':');
+	tokenizer.expect('{');
+
+	if (count < 0) {
+		throw std::runtime_error("Invalid length.");
+	}
+
+	return static_cast <std::size_t>(count);
+}
+
+
+void StreamUnserializer::endBytes(const char *bytes) {
+
+	const std::size_t length = m_bytesLength - 2;
+
+	if (bytes[0] != '"' || bytes[length + 1] != '"') {
+		throw std::runtime_error("Expected '\"'.");
+	}
+
+	m_token.clear();
+
+	if (m_tokenKind == TOKEN_STRING_HEADER) {
+
+		m_handler->onString(bytes + 1, length);
+
+		startToken(TOKEN_STRING_END, ';', 1);
+
+	} else {
+
+		m_className.assign(bytes + 1, length);
+
+		startToken(TOKEN_OBJECT_END, '{', 1);
+	}
+
+	m_bytes.clear();
+}
+
+
+void StreamUnserializer::beginArray(const std::size_t count) {
+
+	Frame frame;
+	frame.expectingKey = true;
+	frame.remaining = count;
+
+	m_frames.push_back(frame);
+	m_state = STATE_TYPE;
+}
+
+
+void StreamUnserializer::endValue() {
+
+	m_state = STATE_TYPE;
+
+	if (!m_frames.empty()) {
+		m_frames.back().expectingKey = !m_frames.back().expectingKey;
+	}
+}
+
+
+} // namespace pherialize
@@ -0,0 +1,167 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_STREAMUNSERIALIZER_HPP_INCLUDED
+#define PHERIALIZE_STREAMUNSERIALIZER_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+#include "pherialize/export.hpp"
+
+#include "pherialize/Mixed.hpp"
+#include "pherialize/MixedBuilder.hpp"
+#include "pherialize/Tokenizer.hpp"
+#include "pherialize/UnserializeHandler.hpp"
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+
+namespace pherialize {
+
+
+/** Unserializes data which arrives in chunks, such as from a socket.
+  *
+  * Chunks are pushed with feed(), and are parsed as far as possible
+  * right away: a value may be split anywhere, including inside a number
+  * or a string. The stream may contain several consecutive top-level
+  * values, each of which is made available as soon as it is complete.
+  *
+  * Only the characters of the token being read are buffered across
+  * chunks; a string entirely contained in a chunk is passed to the
+  * handler without being copied.
+  */
+class PHERIALIZE_EXPORT StreamUnserializer {
+
+public:
+
+	/** Constructs a new stream unserializer which builds Mixed values,
+	  * to be retrieved with nextObject().
+	  */
+	StreamUnserializer();
+
+	/** Constructs a new stream unserializer which reports values to
+	  * the given handler.
+	  *
+	  * @param handler handler to receive the values; it must remain
+	  * valid for the lifetime of the unserializer
+	  */
+	StreamUnserializer(UnserializeHandler &handler);
+
+	/** Parses a chunk of data.
+	  *
+	  * @param data pointer to the chunk; it is not referenced after
+	  * this function returns
+	  * @param length length of the chunk, in bytes
+	  * @throw std::runtime_error if a parsing error occurs; the
+	  * unserializer cannot be used anymore after an error
+	  */
+	void feed(const char *data, const std::size_t length);
+
+	/** Parses a chunk of data.
+	  *
+	  * @param data chunk of data
+	  * @throw std::runtime_error if a parsing error occurs; the
+	  * unserializer cannot be used anymore after an error
+	  */
+	void feed(const std::string &data);
+
+	/** Removes the oldest complete top-level value, when building
+	  * Mixed values.
+	  *
+	  * @return a Mixed object, or NULL if no value is complete yet
+	  * or if the values are reported to a handler
+	  */
+	shared_ptr <Mixed> nextObject();
+
+	/** Returns whether the data fed so far ends on a value boundary.
+	  *
+	  * @return true if no value is partially read, or false otherwise
+	  */
+	bool isComplete() const;
+
+	/** Signals the end of the stream.
+	  *
+	  * @throw std::runtime_error if a value is partially read
+	  */
+	void finish();
+
+private:
+
+	StreamUnserializer(const StreamUnserializer &);
+	StreamUnserializer &operator=(const StreamUnserializer &);
+
+
+	enum State {
+		STATE_TYPE,    // expecting a type tag, or '}' instead of a key
+		STATE_TOKEN,   // reading a token, up to a terminator character
+		STATE_BYTES    // reading a quoted string of known length
+	};
+
+	enum TokenKind {
+		TOKEN_SCALAR,         // "i:42;"
+		TOKEN_ARRAY,          // "a:2:{"
+		TOKEN_STRING_HEADER,  // "s:3:"
+		TOKEN_STRING_END,     // ";"
+		TOKEN_OBJECT_HEADER,  // "O:8:"
+		TOKEN_OBJECT_END      // ":2:{"
+	};
+
+	struct Frame {
+		bool expectingKey;
+		std::size_t remaining;   // number of elements not read yet
+	};
+
+
+	void parse(const char *data, const std::size_t length);
+
+	void startValue(const char type);
+	void startToken(const TokenKind kind, const char terminator, const int terminatorCount);
+	void endToken();
+	void endBytes(const char *bytes);
+	void endValue();
+	void beginArray(const std::size_t count);
+
+	static std::size_t readCount(Tokenizer &tokenizer);
+
+
+	MixedBuilder m_builder;
+	UnserializeHandler *m_handler;
+
+	State m_state;
+	bool m_failed;
+
+	TokenKind m_tokenKind;
+	std::string m_token;
+	char m_terminator;
+	int m_terminatorCount;
+
+	std::string m_bytes;
+	std::size_t m_bytesLength;
+
+	std::string m_className;
+
+	std::vector <Frame> m_frames;
+};
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_STREAMUNSERIALIZER_HPP_INCLUDED
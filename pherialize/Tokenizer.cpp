@@ -0,0 +1,615 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "pherialize/Tokenizer.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <limits>
+#include <cstring>
+#include <cstdlib>
+#include <clocale>
+
+#include <boost/format.hpp>
+
+
+
+namespace pherialize {
+
+
+// Powers of ten which are exactly representable as doubles
+static const double EXACT_POWERS_OF_TEN[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+	1e21, 1e22
+};
+
+// Maximum number of significant digits accumulated in the mantissa
+static const int MAX_MANTISSA_DIGITS = 19;
+
+
+/** Converts decimal digits to a double with strtod(), which rounds
+  * correctly. The digits are copied (to the stack, unless there are
+  * many of them) so that the decimal point of the current locale can
+  * be substituted for '.'.
+  *
+  * @param begin first character of the number (without sign)
+  * @param end end of the number
+  * @return value
+  */
+static double convertDecimal(const char *begin, const char *end) {
+
+	const char *decimalPoint = std::localeconv()->decimal_point;
+	const std::size_t decimalPointLength = std::strlen(decimalPoint);
+
+	const std::size_t maxLength = (end - begin) * decimalPointLength + 1;
+
+	char stackBuffer[64];
+	std::string heapBuffer;
+
+	char *buffer = stackBuffer;
+
+	if (maxLength > sizeof(stackBuffer)) {
+		heapBuffer.resize(maxLength);
+		buffer = &heapBuffer[0];
+	}
+
+	char *q = buffer;
+
+	for (const char *p = begin ; p != end ; ++p) {
+
+		if (*p == '.') {
+			std::memcpy(q, decimalPoint, decimalPointLength);
+			q += decimalPointLength;
+		} else {
+			*q++ = *p;
+		}
+	}
+
+	*q = '\0';
+
+	return std::strtod(buffer, NULL);
+}
+
+
+/** Parses an unsigned decimal number, as accepted by PHP: digits with
+  * an optional fractional part, and an optional exponent (eg. "1.5",
+  * ".5", "1.", "1.0E+25").
+  *
+  * When the digits fit in a 53-bit mantissa and the exponent is small,
+  * the result is computed with a single floating-point operation, which
+  * is correctly rounded (Clinger's fast path). Other numbers go through
+  * strtod().
+  *
+  * @param begin first character to parse
+  * @param end end of data
+  * @param value will receive the value
+  * @return pointer to the first character after the number, or NULL
+  * if the number is invalid
+  */
+static const char *parseDecimal(const char *begin, const char *end, double &value) {
+
+	const char *p = begin;
+
+	std::uint64_t mantissa = 0;
+	int digits = 0;          // significant digits in mantissa
+	int exponent = 0;        // decimal exponent of the mantissa
+	bool exact = true;       // false if non-zero digits have been dropped
+	bool anyDigit = false;
+
+	for (bool fraction = false ; p < end ; ++p) {
+
+		if (*p == '.' && !fraction) {
+			fraction = true;
+			continue;
+		}
+
+		const unsigned int d = static_cast <unsigned char>(*p) - '0';
+
+		if (d > 9) {
+			break;
+		}
+
+		anyDigit = true;
+
+		if (mantissa == 0 && d == 0) {
+
+			// Leading zero
+			if (fraction) {
+				--exponent;
+			}
+
+		} else if (digits < MAX_MANTISSA_DIGITS) {
+
+			mantissa = mantissa * 10 + d;
+			++digits;
+
+			if (fraction) {
+				--exponent;
+			}
+
+		} else {
+
+			// Digit does not fit in the mantissa
+			if (d != 0) {
+				exact = false;
+			}
+
+			if (!fraction) {
+				++exponent;
+			}
+		}
+	}
+
+	if (!anyDigit) {
+		return NULL;
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E')) {
+
+		++p;
+
+		bool negativeExponent = false;
+
+		if (p < end && (*p == '-' || *p == '+')) {
+			negativeExponent = (*p == '-');
+			++p;
+		}
+
+		if (p == end || *p < '0' || *p > '9') {
+			return NULL;
+		}
+
+		int exp = 0;
+
+		for ( ; p < end && *p >= '0' && *p <= '9' ; ++p) {
+
+			// Anything larger overflows or underflows anyway
+			if (exp < 100000) {
+				exp = exp * 10 + (*p - '0');
+			}
+		}
+
+		exponent += negativeExponent ? -exp : exp;
+	}
+
+	if (mantissa == 0) {
+
+		value = 0;
+
+	} else if (exact && mantissa <= (static_cast <std::uint64_t>(1) << 53) &&
+	           exponent >= -22 && exponent <= 22) {
+
+		value = static_cast <double>(mantissa);
+
+		if (exponent < 0) {
+			value /= EXACT_POWERS_OF_TEN[-exponent];
+		} else {
+			value *= EXACT_POWERS_OF_TEN[exponent];
+		}
+
+	} else {
+
+		value = convertDecimal(begin, p);
+	}
+
+	return p;
+}
+
+
+Tokenizer::Tokenizer(const char *data, const std::size_t length) {
+
+	m_data = data;
+	m_pos = 0;
+	m_length = length;
+}
+
+
+const char *Tokenizer::data() const {
+	return m_data;
+}
+
+
+std::size_t Tokenizer::length() const {
+	return m_length;
+}
+
+
+std::size_t Tokenizer::position() const {
+	return m_pos;
+}
+
+
+std::size_t Tokenizer::remaining() const {
+	return m_length - m_pos;
+}
+
+
+char Tokenizer::peek() const {
+
+	return m_pos < m_length ? m_data[m_pos] : '\0';
+}
+
+
+void Tokenizer::expect(const char c) {
+
+	if (peek() != c) {
+		throw std::runtime_error(
+			(boost::format("Expected '%1%'.") % c).str()
+		);
+	}
+
+	++m_pos;
+}
+
+
+bool Tokenizer::match(const char *bytes, const std::size_t length) {
+
+	if (length > remaining() || std::memcmp(m_data + m_pos, bytes, length) != 0) {
+		return false;
+	}
+
+	m_pos += length;
+
+	return true;
+}
+
+
+std::int64_t Tokenizer::readInteger() {
+
+	bool negative = false;
+
+	if (peek() == '-') {
+		negative = true;
+		++m_pos;
+	} else if (peek() == '+') {
+		++m_pos;
+	}
+
+	// The magnitude is accumulated unsigned, as it may be up
+	// to 2^63 for a negative number
+	const std::uint64_t limit = negative
+		? static_cast <std::uint64_t>(INT64_MAX) + 1
+		: static_cast <std::uint64_t>(INT64_MAX);
+
+	const std::size_t start = m_pos;
+	std::uint64_t number = 0;
+
+	while (m_pos < m_length) {
+
+		const unsigned int digit = static_cast <unsigned char>(m_data[m_pos]) - '0';
+
+		if (digit > 9) {
+			break;
+		}
+
+		if (number > (limit - digit) / 10) {
+			throw std::runtime_error("Integer overflow.");
+		}
+
+		number = number * 10 + digit;
+		++m_pos;
+	}
+
+	if (m_pos == start) {
+		throw std::runtime_error("Expected number.");
+	}
+
+	if (negative && number != 0) {
+		return -static_cast <std::int64_t>(number - 1) - 1;
+	}
+
+	return static_cast <std::int64_t>(number);
+}
+
+
+std::size_t Tokenizer::readLength() {
+
+	const std::int64_t length = readInteger();
+
+	if (length < 0 || static_cast <std::uint64_t>(length) > SIZE_MAX) {
+		throw std::runtime_error("Invalid length.");
+	}
+
+	return static_cast <std::size_t>(length);
+}
+
+
+std::size_t Tokenizer::readCount() {
+
+	const std::size_t count = readLength();
+
+	// Each element takes at least 4 characters ("N;N;"), which bounds
+	// the memory reserved for a hostile element count
+	if (count > remaining() / 4) {
+		throw std::runtime_error("Invalid element count.");
+	}
+
+	return count;
+}
+
+
+void Tokenizer::readQuoted(const char *&str, const std::size_t length) {
+
+	if (length + 2 /* "..." */ > m_length - m_pos) {
+		throw std::runtime_error("Invalid string length.");
+	}
+
+	expect('"');
+
+	str = m_data + m_pos;
+	m_pos += length;
+
+	expect('"');
+}
+
+
+char Tokenizer::readType() {
+
+	// A NUL character in the data is not the end of data
+	if (remaining() == 0) {
+		return '\0';
+	}
+
+	const char type = m_data[m_pos];
+
+	switch (type) {
+
+		case 's':
+		case 'i':
+		case 'b':
+		case 'd':
+		case 'N':
+		case 'a':
+		case 'O':
+
+			++m_pos;
+			return type;
+	}
+
+	throw std::runtime_error(
+		(boost::format("Unable to unserialize unknown type '%1%'.") % type).str()
+	);
+}
+
+
+void Tokenizer::readNull() {
+
+	expect(';');
+}
+
+
+std::int64_t Tokenizer::readInt() {
+
+	expect(':');
+
+	const std::int64_t number = readInteger();
+
+	expect(';');
+
+	return number;
+}
+
+
+bool Tokenizer::readBool() {
+
+	expect(':');
+
+	const std::int64_t number = readInteger();
+
+	expect(';');
+
+	return number ? true : false;
+}
+
+
+double Tokenizer::readDouble() {
+
+	expect(':');
+
+	const char *start = m_data + m_pos;
+	const char *end = m_data + m_length;
+	const char *p = start;
+
+	bool negative = false;
+
+	if (p < end && (*p == '-' || *p == '+')) {
+		negative = (*p == '-');
+		++p;
+	}
+
+	double number;
+
+	if (end - p >= 3 && std::memcmp(p, "INF", 3) == 0) {
+
+		number = std::numeric_limits <double>::infinity();
+		p += 3;
+
+	} else if (p == start && end - p >= 3 && std::memcmp(p, "NAN", 3) == 0) {
+
+		number = std::numeric_limits <double>::quiet_NaN();
+		p += 3;
+
+	} else {
+
+		const char *digitsStart = p;
+		p = parseDecimal(p, end, number);
+
+		if (p == NULL) {
+
+			const char *q = digitsStart;
+
+			while (q < end && *q != ';') {
+				++q;
+			}
+
+			throw std::runtime_error(
+				(boost::format("Invalid format for double: '%1%'.") % std::string(start, q)).str()
+			);
+		}
+	}
+
+	m_pos = p - m_data;
+
+	expect(';');
+
+	return negative ? -number : number;
+}
+
+
+void Tokenizer::readString(const char *&str, std::size_t &length) {
+
+	expect(':');
+
+	length = readLength();
+
+	expect(':');
+
+	readQuoted(str, length);
+
+	expect(';');
+}
+
+
+std::size_t Tokenizer::readArrayBegin() {
+
+	expect(':');
+
+	const std::size_t count = readCount();
+
+	expect(':');
+	expect('{');
+
+	return count;
+}
+
+
+std::size_t Tokenizer::readObjectBegin(const char *&className, std::size_t &classNameLength) {
+
+	expect(':');
+
+	classNameLength = readLength();
+
+	expect(':');
+
+	readQuoted(className, classNameLength);
+
+	expect(':');
+
+	const std::size_t count = readCount();
+
+	expect(':');
+	expect('{');
+
+	return count;
+}
+
+
+bool Tokenizer::readArrayEnd() {
+
+	if (peek() == '}') {
+		++m_pos;
+		return true;
+	}
+
+	return false;
+}
+
+
+void Tokenizer::expectElement() {
+
+	if (peek() == '}') {
+		throw std::runtime_error("Element count mismatch.");
+	}
+}
+
+
+void Tokenizer::expectArrayEnd() {
+
+	if (!readArrayEnd()) {
+		throw std::runtime_error("Element count mismatch.");
+	}
+}
+
+
+void Tokenizer::skipValue() {
+
+	std::size_t count = 0;
+
+	switch (readType()) {
+
+		case 's': {
+
+			const char *str;
+			std::size_t length;
+
+			readString(str, length);
+			return;
+		}
+		case 'i':
+
+			readInt();
+			return;
+
+		case 'a':
+
+			count = readArrayBegin();
+			break;
+
+		case 'O': {
+
+			const char *className;
+			std::size_t classNameLength;
+
+			count = readObjectBegin(className, classNameLength);
+			break;
+		}
+		case 'N':
+
+			readNull();
+			return;
+
+		case 'b':
+
+			readBool();
+			return;
+
+		case 'd':
+
+			readDouble();
+			return;
+
+		case '\0':
+
+			throw std::runtime_error("Unexpected end of data.");
+	}
+
+	// Array or object elements
+	for (std::size_t i = 0 ; i < count ; ++i) {
+
+		expectElement();
+
+		skipValue();  // key
+		skipValue();  // value
+	}
+
+	expectArrayEnd();
+}
+
+
+} // namespace pherialize
@@ -0,0 +1,221 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_TOKENIZER_HPP_INCLUDED
+#define PHERIALIZE_TOKENIZER_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+#include "pherialize/export.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace pherialize {
+
+
+/** Reads the tokens of PHP-serialize()d data from a caller-owned
+  * buffer. The buffer is not copied, and need not be NUL-terminated.
+  *
+  * Values are read in two steps: readType() consumes the type tag,
+  * then the matching read*() function consumes the rest of the value.
+  * All functions throw std::runtime_error on malformed input.
+  */
+class PHERIALIZE_EXPORT Tokenizer {
+
+public:
+
+	/** Constructs a new tokenizer over a buffer.
+	  *
+	  * @param data pointer to serialized data
+	  * @param length length of data, in bytes
+	  */
+	Tokenizer(const char *data, const std::size_t length);
+
+	/** Returns the buffer this tokenizer reads from.
+	  *
+	  * @return pointer to serialized data
+	  */
+	const char *data() const;
+
+	/** Returns the length of the buffer.
+	  *
+	  * @return length of data, in bytes
+	  */
+	std::size_t length() const;
+
+	/** Returns the current read position.
+	  *
+	  * @return offset of the next character to read
+	  */
+	std::size_t position() const;
+
+	/** Returns the number of characters left to read.
+	  *
+	  * @return number of remaining characters
+	  */
+	std::size_t remaining() const;
+
+	/** Returns the next character without consuming it.
+	  *
+	  * @return next character, or '\0' at end of data
+	  */
+	char peek() const;
+
+	/** Consumes the next character, which must be the one given.
+	  *
+	  * @param c expected character
+	  * @throw std::runtime_error if the next character is different
+	  */
+	void expect(const char c);
+
+	/** Consumes the next characters if they are the ones given.
+	  *
+	  * @param bytes expected characters
+	  * @param length number of characters
+	  * @return true if the characters have been consumed, or false
+	  * if they do not match (nothing is consumed)
+	  */
+	bool match(const char *bytes, const std::size_t length);
+
+	/** Reads a signed decimal integer. This is used for all the
+	  * integers in the data: int and bool values, lengths and counts.
+	  *
+	  * @throw std::runtime_error if no digits can be read, or if the
+	  * value does not fit in 64 bits
+	  * @return integer value
+	  */
+	std::int64_t readInteger();
+
+	/** Reads the type tag of the next value.
+	  *
+	  * @throw std::runtime_error if the type is unknown
+	  * @return one of 's', 'i', 'b', 'd', 'N', 'a' or 'O', or '\0'
+	  * at end of data (in which case nothing is consumed)
+	  */
+	char readType();
+
+	/** Reads the remainder of a null value ("N;").
+	  */
+	void readNull();
+
+	/** Reads the remainder of an integer value ("i:42;").
+	  *
+	  * @return integer value
+	  */
+	std::int64_t readInt();
+
+	/** Reads the remainder of a boolean value ("b:1;").
+	  *
+	  * @return boolean value
+	  */
+	bool readBool();
+
+	/** Reads the remainder of a double value ("d:0.5;"). All the
+	  * forms written by PHP are accepted, including exponents
+	  * ("d:1.0E+25;"), "INF", "-INF" and "NAN". Parsing does not
+	  * depend on the current locale.
+	  *
+	  * @return double value
+	  */
+	double readDouble();
+
+	/** Reads the remainder of a string value ("s:3:"abc";").
+	  * No copy is made: the returned pointer references the buffer.
+	  *
+	  * @param str will receive a pointer to the first character
+	  * @param length will receive the length of the string
+	  */
+	void readString(const char *&str, std::size_t &length);
+
+	/** Reads the header of an array ("a:2:{"). Elements follow
+	  * as key/value pairs, until readArrayEnd() returns true.
+	  *
+	  * The declared number of elements is checked against the size
+	  * of the remaining data, so that it can safely be used to reserve
+	  * memory for the elements.
+	  *
+	  * @throw std::runtime_error if the data is too short to contain
+	  * the declared number of elements
+	  * @return declared number of elements
+	  */
+	std::size_t readArrayBegin();
+
+	/** Reads the header of an object ("O:8:"stdClass":2:{").
+	  * Properties follow as key/value pairs, until readArrayEnd()
+	  * returns true.
+	  *
+	  * The declared number of properties is checked as in readArrayBegin().
+	  *
+	  * @param className will receive a pointer to the class name
+	  * @param classNameLength will receive the length of the class name
+	  * @throw std::runtime_error if the data is too short to contain
+	  * the declared number of properties
+	  * @return declared number of properties
+	  */
+	std::size_t readObjectBegin(const char *&className, std::size_t &classNameLength);
+
+	/** Consumes the closing brace of an array or object, if it is
+	  * the next character.
+	  *
+	  * @return true if the end of the array has been reached,
+	  * or false if more elements follow
+	  */
+	bool readArrayEnd();
+
+	/** Checks that another element follows, when fewer elements than
+	  * declared have been read.
+	  *
+	  * @throw std::runtime_error if the end of the array is reached
+	  */
+	void expectElement();
+
+	/** Consumes the closing brace of an array or object, once the
+	  * declared number of elements has been read.
+	  *
+	  * @throw std::runtime_error if more elements follow
+	  */
+	void expectArrayEnd();
+
+	/** Reads a whole value without decoding it. String and class
+	  * name contents are skipped using their length prefix.
+	  *
+	  * @throw std::runtime_error if the value is malformed, if the
+	  * number of elements of an array differs from the declared one,
+	  * or if the end of data has been reached
+	  */
+	void skipValue();
+
+private:
+
+	std::size_t readLength();
+	std::size_t readCount();
+	void readQuoted(const char *&str, const std::size_t length);
+
+
+	const char *m_data;
+	std::size_t m_pos;
+	std::size_t m_length;
+};
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_TOKENIZER_HPP_INCLUDED
@@ -0,0 +1,76 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "pherialize/UnserializeHandler.hpp"
+
+
+
+namespace pherialize {
+
+
+UnserializeHandler::~UnserializeHandler() {
+
+}
+
+
+void UnserializeHandler::onNull() {
+
+}
+
+
+void UnserializeHandler::onInt(const std::int64_t /* value */) {
+
+}
+
+
+void UnserializeHandler::onBool(const bool /* value */) {
+
+}
+
+
+void UnserializeHandler::onDouble(const double /* value */) {
+
+}
+
+
+void UnserializeHandler::onString(const char * /* str */, const std::size_t /* length */) {
+
+}
+
+
+void UnserializeHandler::onArrayBegin(const std::size_t /* count */) {
+
+}
+
+
+void UnserializeHandler::onObjectBegin(const char * /* className */, const std::size_t /* classNameLength */, const std::size_t /* count */) {
+
+}
+
+
+void UnserializeHandler::onKey() {
+
+}
+
+
+void UnserializeHandler::onArrayEnd() {
+
+}
+
+
+} // namespace pherialize
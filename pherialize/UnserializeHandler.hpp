@@ -0,0 +1,108 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_UNSERIALIZEHANDLER_HPP_INCLUDED
+#define PHERIALIZE_UNSERIALIZEHANDLER_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+#include "pherialize/export.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace pherialize {
+
+
+/** Receives the values of serialized data as a sequence of events,
+  * instead of a tree of Mixed values.
+  *
+  * Array (and object) elements are reported between onArrayBegin()
+  * (or onObjectBegin()) and onArrayEnd(). For each element, onKey()
+  * is called first, then the key is reported (by onInt() or onString()),
+  * followed by the value.
+  *
+  * All the functions do nothing by default. Pointers passed to
+  * the handler reference the serialized data and are only valid
+  * as long as it is.
+  */
+class PHERIALIZE_EXPORT UnserializeHandler {
+
+public:
+
+	virtual ~UnserializeHandler();
+
+	/** Called for a null value.
+	  */
+	virtual void onNull();
+
+	/** Called for an integer value.
+	  *
+	  * @param value integer value
+	  */
+	virtual void onInt(const std::int64_t value);
+
+	/** Called for a boolean value.
+	  *
+	  * @param value boolean value
+	  */
+	virtual void onBool(const bool value);
+
+	/** Called for a double value.
+	  *
+	  * @param value double value
+	  */
+	virtual void onDouble(const double value);
+
+	/** Called for a string value.
+	  *
+	  * @param str pointer to the characters of the string (not NUL-terminated)
+	  * @param length length of the string, in bytes
+	  */
+	virtual void onString(const char *str, const std::size_t length);
+
+	/** Called at the start of an array.
+	  *
+	  * @param count declared number of elements
+	  */
+	virtual void onArrayBegin(const std::size_t count);
+
+	/** Called at the start of an object. Its properties are then
+	  * reported as array elements.
+	  *
+	  * @param className pointer to the characters of the class name
+	  * @param classNameLength length of the class name, in bytes
+	  * @param count declared number of properties
+	  */
+	virtual void onObjectBegin(const char *className, const std::size_t classNameLength, const std::size_t count);
+
+	/** Called before the key of each array or object element.
+	  */
+	virtual void onKey();
+
+	/** Called at the end of an array or object.
+	  */
+	virtual void onArrayEnd();
+};
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_UNSERIALIZEHANDLER_HPP_INCLUDED
@@ -0,0 +1,991 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "pherialize/serialize.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+
+#include <boost/format.hpp>
+
+
+
+namespace pherialize {
+
+
+static std::size_t unsignedLength(unsigned long long v) {
+
+	std::size_t length = 1;
+
+	while (v >= 10) {
+		v /= 10;
+		++length;
+	}
+
+	return length;
+}
+
+
+static std::size_t integerLength(const long long v) {
+
+	if (v < 0) {
+		return 1 + unsignedLength(0ULL - static_cast <unsigned long long>(v));
+	}
+
+	return unsignedLength(static_cast <unsigned long long>(v));
+}
+
+
+static char *writeUnsigned(char *p, unsigned long long v) {
+
+	char *end = p + unsignedLength(v);
+	char *q = end;
+
+	do {
+		*--q = static_cast <char>('0' + v % 10);
+		v /= 10;
+	} while (v != 0);
+
+	return end;
+}
+
+
+static char *writeInteger(char *p, const long long v) {
+
+	if (v < 0) {
+		*p++ = '-';
+		return writeUnsigned(p, 0ULL - static_cast <unsigned long long>(v));
+	}
+
+	return writeUnsigned(p, static_cast <unsigned long long>(v));
+}
+
+
+/** Converts a double array key to an integer as PHP does (see
+  * zend_dval_to_lval() in PHP sources): NAN and infinities give 0,
+  * other values are truncated, modulo 2^64 if they are out of range.
+  *
+  * @param value key value
+  * @return integer key
+  */
+static long long doubleKeyToInteger(const double value) {
+
+	const double twoPow63 = 9223372036854775808.0;
+	const double twoPow64 = 18446744073709551616.0;
+
+	if (!std::isfinite(value)) {
+		return 0;
+	} else if (value >= -twoPow63 && value < twoPow63) {
+		return static_cast <long long>(value);
+	}
+
+	// Out of range: all the values are integers at this magnitude
+	double mod = std::fmod(value, twoPow64);
+
+	if (mod < 0) {
+		mod += twoPow64;
+	}
+
+	if (mod >= twoPow63) {
+		mod -= twoPow64;
+	}
+
+	return static_cast <long long>(mod);
+}
+
+
+static char *writeChars(char *p, const char *str, const std::size_t length) {
+
+	std::memcpy(p, str, length);
+	return p + length;
+}
+
+
+/** A floating-point number with a 64-bit significand: f * 2^e.
+  */
+struct DiyFp {
+
+	std::uint64_t f;
+	int e;
+};
+
+
+static DiyFp makeDiyFp(const std::uint64_t f, const int e) {
+
+	DiyFp x;
+	x.f = f;
+	x.e = e;
+
+	return x;
+}
+
+
+static DiyFp normalize(DiyFp x) {
+
+	while ((x.f & 0x8000000000000000ULL) == 0) {
+		x.f <<= 1;
+		--x.e;
+	}
+
+	return x;
+}
+
+
+/** Multiplies two numbers, rounding the 128-bit product of their
+  * significands to its upper 64 bits.
+  */
+static DiyFp multiply(const DiyFp &x, const DiyFp &y) {
+
+	const std::uint64_t mask = 0xFFFFFFFFULL;
+
+	const std::uint64_t a = x.f >> 32, b = x.f & mask;
+	const std::uint64_t c = y.f >> 32, d = y.f & mask;
+
+	const std::uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+	const std::uint64_t mid = (bd >> 32) + (ad & mask) + (bc & mask) + (1ULL << 31);
+
+	return makeDiyFp(ac + (ad >> 32) + (bc >> 32) + (mid >> 32), x.e + y.e + 64);
+}
+
+
+/** Normalized powers of ten 10^k, for k = -348, -340, ..., 340, as
+  * { significand, binary exponent, decimal exponent }.
+  */
+static const struct {
+	std::uint64_t f;
+	short e;
+	short k;
+} CACHED_POWERS[] = {
+	{ 0xfa8fd5a0081c0288ULL, -1220, -348 },
+	{ 0xbaaee17fa23ebf76ULL, -1193, -340 },
+	{ 0x8b16fb203055ac76ULL, -1166, -332 },
+	{ 0xcf42894a5dce35eaULL, -1140, -324 },
+	{ 0x9a6bb0aa55653b2dULL, -1113, -316 },
+	{ 0xe61acf033d1a45dfULL, -1087, -308 },
+	{ 0xab70fe17c79ac6caULL, -1060, -300 },
+	{ 0xff77b1fcbebcdc4fULL, -1034, -292 },
+	{ 0xbe5691ef416bd60cULL, -1007, -284 },
+	{ 0x8dd01fad907ffc3cULL, -980, -276 },
+	{ 0xd3515c2831559a83ULL, -954, -268 },
+	{ 0x9d71ac8fada6c9b5ULL, -927, -260 },
+	{ 0xea9c227723ee8bcbULL, -901, -252 },
+	{ 0xaecc49914078536dULL, -874, -244 },
+	{ 0x823c12795db6ce57ULL, -847, -236 },
+	{ 0xc21094364dfb5637ULL, -821, -228 },
+	{ 0x9096ea6f3848984fULL, -794, -220 },
+	{ 0xd77485cb25823ac7ULL, -768, -212 },
+	{ 0xa086cfcd97bf97f4ULL, -741, -204 },
+	{ 0xef340a98172aace5ULL, -715, -196 },
+	{ 0xb23867fb2a35b28eULL, -688, -188 },
+	{ 0x84c8d4dfd2c63f3bULL, -661, -180 },
+	{ 0xc5dd44271ad3cdbaULL, -635, -172 },
+	{ 0x936b9fcebb25c996ULL, -608, -164 },
+	{ 0xdbac6c247d62a584ULL, -582, -156 },
+	{ 0xa3ab66580d5fdaf6ULL, -555, -148 },
+	{ 0xf3e2f893dec3f126ULL, -529, -140 },
+	{ 0xb5b5ada8aaff80b8ULL, -502, -132 },
+	{ 0x87625f056c7c4a8bULL, -475, -124 },
+	{ 0xc9bcff6034c13053ULL, -449, -116 },
+	{ 0x964e858c91ba2655ULL, -422, -108 },
+	{ 0xdff9772470297ebdULL, -396, -100 },
+	{ 0xa6dfbd9fb8e5b88fULL, -369, -92 },
+	{ 0xf8a95fcf88747d94ULL, -343, -84 },
+	{ 0xb94470938fa89bcfULL, -316, -76 },
+	{ 0x8a08f0f8bf0f156bULL, -289, -68 },
+	{ 0xcdb02555653131b6ULL, -263, -60 },
+	{ 0x993fe2c6d07b7facULL, -236, -52 },
+	{ 0xe45c10c42a2b3b06ULL, -210, -44 },
+	{ 0xaa242499697392d3ULL, -183, -36 },
+	{ 0xfd87b5f28300ca0eULL, -157, -28 },
+	{ 0xbce5086492111aebULL, -130, -20 },
+	{ 0x8cbccc096f5088ccULL, -103, -12 },
+	{ 0xd1b71758e219652cULL, -77, -4 },
+	{ 0x9c40000000000000ULL, -50, 4 },
+	{ 0xe8d4a51000000000ULL, -24, 12 },
+	{ 0xad78ebc5ac620000ULL, 3, 20 },
+	{ 0x813f3978f8940984ULL, 30, 28 },
+	{ 0xc097ce7bc90715b3ULL, 56, 36 },
+	{ 0x8f7e32ce7bea5c70ULL, 83, 44 },
+	{ 0xd5d238a4abe98068ULL, 109, 52 },
+	{ 0x9f4f2726179a2245ULL, 136, 60 },
+	{ 0xed63a231d4c4fb27ULL, 162, 68 },
+	{ 0xb0de65388cc8ada8ULL, 189, 76 },
+	{ 0x83c7088e1aab65dbULL, 216, 84 },
+	{ 0xc45d1df942711d9aULL, 242, 92 },
+	{ 0x924d692ca61be758ULL, 269, 100 },
+	{ 0xda01ee641a708deaULL, 295, 108 },
+	{ 0xa26da3999aef774aULL, 322, 116 },
+	{ 0xf209787bb47d6b85ULL, 348, 124 },
+	{ 0xb454e4a179dd1877ULL, 375, 132 },
+	{ 0x865b86925b9bc5c2ULL, 402, 140 },
+	{ 0xc83553c5c8965d3dULL, 428, 148 },
+	{ 0x952ab45cfa97a0b3ULL, 455, 156 },
+	{ 0xde469fbd99a05fe3ULL, 481, 164 },
+	{ 0xa59bc234db398c25ULL, 508, 172 },
+	{ 0xf6c69a72a3989f5cULL, 534, 180 },
+	{ 0xb7dcbf5354e9beceULL, 561, 188 },
+	{ 0x88fcf317f22241e2ULL, 588, 196 },
+	{ 0xcc20ce9bd35c78a5ULL, 614, 204 },
+	{ 0x98165af37b2153dfULL, 641, 212 },
+	{ 0xe2a0b5dc971f303aULL, 667, 220 },
+	{ 0xa8d9d1535ce3b396ULL, 694, 228 },
+	{ 0xfb9b7cd9a4a7443cULL, 720, 236 },
+	{ 0xbb764c4ca7a44410ULL, 747, 244 },
+	{ 0x8bab8eefb6409c1aULL, 774, 252 },
+	{ 0xd01fef10a657842cULL, 800, 260 },
+	{ 0x9b10a4e5e9913129ULL, 827, 268 },
+	{ 0xe7109bfba19c0c9dULL, 853, 276 },
+	{ 0xac2820d9623bf429ULL, 880, 284 },
+	{ 0x80444b5e7aa7cf85ULL, 907, 292 },
+	{ 0xbf21e44003acdd2dULL, 933, 300 },
+	{ 0x8e679c2f5e44ff8fULL, 960, 308 },
+	{ 0xd433179d9c8cb841ULL, 986, 316 },
+	{ 0x9e19db92b4e31ba9ULL, 1013, 324 },
+	{ 0xeb96bf6ebadf77d9ULL, 1039, 332 },
+	{ 0xaf87023b9bf0ee6bULL, 1066, 340 },
+};
+
+
+/** Finds the shortest digits of a value with Grisu3 (F. Loitsch,
+  * "Printing Floating-Point Numbers Quickly and Accurately with
+  * Integers", 2010). The value is scaled by a cached power of ten so
+  * that digits can be generated with 64-bit integer arithmetic. This
+  * fails for about 0.5% of values, for which the result cannot be
+  * proven to be the shortest and closest one.
+  *
+  * @param value value to convert (finite and positive)
+  * @param digits receives the significant digits
+  * @param count receives the number of digits
+  * @param decpt receives the position of the decimal point relative
+  * to the first digit
+  * @return true if the digits have been found, or false otherwise
+  */
+static bool grisu3(const double value, char *digits, std::size_t &count, int &decpt) {
+
+	const std::uint64_t hiddenBit = 0x0010000000000000ULL;
+	const std::uint64_t fractionMask = 0x000FFFFFFFFFFFFFULL;
+
+	std::uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	const int biasedExponent = static_cast <int>(bits >> 52);
+
+	DiyFp v;
+
+	if (biasedExponent == 0) {
+		v = makeDiyFp(bits & fractionMask, -1074);
+	} else {
+		v = makeDiyFp((bits & fractionMask) | hiddenBit, biasedExponent - 1075);
+	}
+
+	// Boundaries: half-way to the neighbouring values; the lower one
+	// is closer when the significand is a power of two
+	const DiyFp plus = normalize(makeDiyFp((v.f << 1) + 1, v.e - 1));
+
+	DiyFp minus = (v.f == hiddenBit && biasedExponent > 1)
+		? makeDiyFp((v.f << 2) - 1, v.e - 2)
+		: makeDiyFp((v.f << 1) - 1, v.e - 1);
+
+	minus.f <<= minus.e - plus.e;
+	minus.e = plus.e;
+
+	const DiyFp w = normalize(v);
+
+	// Find a power of ten c such that the exponent of w * c is in
+	// [-60, -32]: the integral part of the scaled values then fits
+	// in 32 bits
+	const int minExponent = -60 - (w.e + 64);
+	const int k = static_cast <int>(std::ceil((minExponent + 63) * 0.30102999566398114));
+	const std::size_t index = static_cast <std::size_t>((348 + k - 1) / 8 + 1);
+
+	const DiyFp cachedPower = makeDiyFp(CACHED_POWERS[index].f, CACHED_POWERS[index].e);
+
+	const DiyFp scaledW = multiply(w, cachedPower);
+	const DiyFp low = multiply(minus, cachedPower);
+	const DiyFp high = multiply(plus, cachedPower);
+
+	// The scaled boundaries are off by at most one unit: only digits
+	// within the unsafe interval are sure to read back to the value
+	std::uint64_t unit = 1;
+
+	const DiyFp tooLow = makeDiyFp(low.f - unit, low.e);
+	const DiyFp tooHigh = makeDiyFp(high.f + unit, high.e);
+
+	std::uint64_t unsafeInterval = tooHigh.f - tooLow.f;
+
+	const int shift = -scaledW.e;
+	const std::uint64_t one = 1ULL << shift;
+
+	std::uint32_t integrals = static_cast <std::uint32_t>(tooHigh.f >> shift);
+	std::uint64_t fractionals = tooHigh.f & (one - 1);
+
+	std::uint32_t divisor = 0;
+	int kappa = 0;
+
+	if (integrals != 0) {
+
+		divisor = 1;
+		kappa = 1;
+
+		while (integrals / divisor >= 10) {
+			divisor *= 10;
+			++kappa;
+		}
+	}
+
+	count = 0;
+
+	std::uint64_t rest, tenKappa, distance;
+
+	for (;;) {
+
+		if (kappa > 0) {
+
+			// Digits of the integral part
+			digits[count++] = static_cast <char>('0' + integrals / divisor);
+
+			integrals %= divisor;
+			--kappa;
+
+			rest = (static_cast <std::uint64_t>(integrals) << shift) + fractionals;
+
+			if (rest < unsafeInterval) {
+
+				tenKappa = static_cast <std::uint64_t>(divisor) << shift;
+				distance = tooHigh.f - scaledW.f;
+				break;
+			}
+
+			divisor /= 10;
+
+		} else {
+
+			// Digits of the fractional part
+			fractionals *= 10;
+			unit *= 10;
+			unsafeInterval *= 10;
+
+			digits[count++] = static_cast <char>('0' + (fractionals >> shift));
+
+			fractionals &= one - 1;
+			--kappa;
+
+			if (fractionals < unsafeInterval) {
+
+				rest = fractionals;
+				tenKappa = one;
+				distance = (tooHigh.f - scaledW.f) * unit;
+				break;
+			}
+		}
+	}
+
+	// Move the last digit towards the value while the result stays
+	// in the safe interval, then check that the result is unique
+	const std::uint64_t smallDistance = distance - unit;
+	const std::uint64_t bigDistance = distance + unit;
+
+	while (rest < smallDistance && unsafeInterval - rest >= tenKappa &&
+	       (rest + tenKappa < smallDistance ||
+	        smallDistance - rest >= rest + tenKappa - smallDistance)) {
+
+		--digits[count - 1];
+		rest += tenKappa;
+	}
+
+	if (rest < bigDistance && unsafeInterval - rest >= tenKappa &&
+	    (rest + tenKappa < bigDistance ||
+	     bigDistance - rest > rest + tenKappa - bigDistance)) {
+
+		return false;
+	}
+
+	if (rest < 2 * unit || rest > unsafeInterval - 4 * unit) {
+		return false;
+	}
+
+	decpt = static_cast <int>(count) + kappa - CACHED_POWERS[index].k;
+
+	return true;
+}
+
+
+/** Finds the shortest decimal digits which read back to the given
+  * value, with the closest digits among the shortest ones. This is
+  * done with grisu3() when possible, or else by formatting the value
+  * with snprintf() at increasing precisions until it reads back with
+  * strtod(): any normal value with up to 15 significant digits reads
+  * back exactly, so only 15, 16 and 17 digits need to be tried;
+  * subnormal values have less precision, and may need fewer.
+  *
+  * @param value value to convert (finite and positive)
+  * @param digits receives the significant digits, without trailing zeros
+  * @param decpt receives the position of the decimal point relative
+  * to the first digit (eg. 1 for 1.5, -2 for 0.0015)
+  * @return number of digits
+  */
+static std::size_t shortestDigits(const double value, char *digits, int &decpt) {
+
+	std::size_t count = 0;
+
+	if (!grisu3(value, digits, count, decpt)) {
+
+		char buffer[MAX_DOUBLE_LENGTH];
+
+		for (int precision = (value < DBL_MIN ? 1 : 15) ; ; ++precision) {
+
+			std::snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, value);
+
+			if (precision == 17 || std::strtod(buffer, NULL) == value) {
+				break;
+			}
+		}
+
+		// Extract digits and exponent from "d.ddde+xx"; the decimal
+		// point depends on the locale, so only digits are considered
+		const char *p = buffer;
+
+		for (count = 0 ; *p != 'e' ; ++p) {
+
+			if (*p >= '0' && *p <= '9') {
+				digits[count++] = *p;
+			}
+		}
+
+		decpt = static_cast <int>(std::strtol(p + 1, NULL, 10)) + 1;
+	}
+
+	while (count > 1 && digits[count - 1] == '0') {
+		--count;
+	}
+
+	return count;
+}
+
+
+/** Formats a double as PHP serialize() does with serialize_precision
+  * set to -1 (see php_gcvt() in PHP sources).
+  *
+  * @param value value to format
+  * @param buffer output buffer, at least MAX_DOUBLE_LENGTH bytes
+  * @return length of formatted value
+  */
+std::size_t formatDouble(const double value, char *buffer) {
+
+	char *p = buffer;
+
+	if (std::isnan(value)) {
+		return writeChars(p, "NAN", 3) - buffer;
+	} else if (std::isinf(value)) {
+		return (value < 0 ? writeChars(p, "-INF", 4) : writeChars(p, "INF", 3)) - buffer;
+	}
+
+	char digits[MAX_DOUBLE_LENGTH];
+	std::size_t count;
+	int decpt;
+
+	if (value == 0) {
+
+		digits[0] = '0';
+		count = 1;
+		decpt = 1;
+
+	} else {
+
+		count = shortestDigits(std::fabs(value), digits, decpt);
+	}
+
+	if (std::signbit(value)) {
+		*p++ = '-';
+	}
+
+	if (decpt < 0 ? decpt < -3 : decpt > 17) {
+
+		// Exponential format (eg. 1.0E+25)
+		int exponent = decpt - 1;
+
+		*p++ = digits[0];
+		*p++ = '.';
+
+		if (count == 1) {
+			*p++ = '0';
+		} else {
+			p = writeChars(p, digits + 1, count - 1);
+		}
+
+		*p++ = 'E';
+
+		if (exponent < 0) {
+			*p++ = '-';
+			exponent = -exponent;
+		} else {
+			*p++ = '+';
+		}
+
+		p = writeUnsigned(p, static_cast <unsigned long long>(exponent));
+
+	} else if (decpt <= 0) {
+
+		// Standard format, below 1 (eg. 0.0015)
+		*p++ = '0';
+		*p++ = '.';
+
+		for (int i = decpt ; i < 0 ; ++i) {
+			*p++ = '0';
+		}
+
+		p = writeChars(p, digits, count);
+
+	} else {
+
+		// Standard format (eg. 1.5, 100)
+		const std::size_t intDigits = static_cast <std::size_t>(decpt);
+
+		if (count <= intDigits) {
+
+			p = writeChars(p, digits, count);
+
+			for (std::size_t i = count ; i < intDigits ; ++i) {
+				*p++ = '0';
+			}
+
+		} else {
+
+			p = writeChars(p, digits, intDigits);
+			*p++ = '.';
+			p = writeChars(p, digits + intDigits, count - intDigits);
+		}
+	}
+
+	return p - buffer;
+}
+
+
+static std::runtime_error invalidKeyError(const Mixed &key) {
+
+	return std::runtime_error(
+		(boost::format("Cannot serialize array key of type %1%.") % key.type()).str()
+	);
+}
+
+
+/** Converts an array key as PHP does: bools, doubles and strings which
+  * are the canonical form of an integer become integers, and null
+  * becomes the empty string.
+  *
+  * @param key key to convert
+  * @param intKey receives the key, if it is an integer
+  * @param strKey receives the key, if it is a string
+  * @throw std::runtime_error if the key is an array
+  * @return true if the key is an integer, or false if it is a string
+  */
+static bool convertKey(const Mixed &key, std::int64_t &intKey, const std::string *&strKey) {
+
+	static const std::string emptyString;
+
+	switch (key.type()) {
+
+		case Mixed::TYPE_INT:
+
+			intKey = key.intValue();
+			return true;
+
+		case Mixed::TYPE_STRING:
+
+			strKey = &key.stringValue();
+			return stringKeyToInteger(strKey->data(), strKey->length(), intKey);
+
+		case Mixed::TYPE_NULL:
+
+			strKey = &emptyString;
+			return false;
+
+		case Mixed::TYPE_BOOL:
+
+			intKey = key.boolValue() ? 1 : 0;
+			return true;
+
+		case Mixed::TYPE_DOUBLE:
+
+			intKey = doubleKeyToInteger(key.doubleValue());
+			return true;
+
+		case Mixed::TYPE_ARRAY:
+
+			break;
+	}
+
+	throw invalidKeyError(key);
+}
+
+
+/** Checks that the keys of a map are still distinct once converted
+  * (eg. "42" and 42, or true and 1), as a PHP array cannot hold
+  * the same key twice.
+  *
+  * @param entries map entries
+  * @throw std::runtime_error if two keys are the same after conversion
+  */
+static void checkConvertedKeys(const std::vector <MixedArray::Entry> &entries) {
+
+	std::unordered_set <std::int64_t> intKeys;
+	std::unordered_set <std::string> strKeys;
+
+	for (std::size_t i = 0 ; i < entries.size() ; ++i) {
+
+		std::int64_t intKey = 0;
+		const std::string *strKey = NULL;
+
+		const bool isInt = convertKey(entries[i].first, intKey, strKey);
+
+		if (isInt ? !intKeys.insert(intKey).second : !strKeys.insert(*strKey).second) {
+
+			throw std::runtime_error(
+				(boost::format("Array key '%1%' appears more than once after conversion.")
+					% (isInt ? std::to_string(intKey) : *strKey)).str()
+			);
+		}
+	}
+}
+
+
+bool stringKeyToInteger(const char *str, const std::size_t length, std::int64_t &value) {
+
+	const bool negative = (length != 0 && str[0] == '-');
+	const char *digits = negative ? str + 1 : str;
+	const std::size_t count = negative ? length - 1 : length;
+
+	// No sign other than '-', no leading zero, no "-0"
+	if (count == 0 || count > 19 || digits[0] < '0' || digits[0] > '9' ||
+	    (digits[0] == '0' && length != 1)) {
+
+		return false;
+	}
+
+	std::uint64_t number = 0;
+
+	for (std::size_t i = 0 ; i < count ; ++i) {
+
+		if (digits[i] < '0' || digits[i] > '9') {
+			return false;
+		}
+
+		number = number * 10 + (digits[i] - '0');
+	}
+
+	if (number > (negative ? 9223372036854775808ULL : 9223372036854775807ULL)) {
+		return false;
+	}
+
+	value = negative
+		? -static_cast <std::int64_t>(number - 1) - 1
+		: static_cast <std::int64_t>(number);
+
+	return true;
+}
+
+
+
+Serializer::Serializer()
+	: m_doublesPos(0) {
+
+}
+
+
+std::size_t Serializer::computeSize(const Mixed &value) {
+
+	m_doubles.clear();
+
+	return valueSize(value);
+}
+
+
+std::string Serializer::serializeObject(const Mixed &value) {
+
+	std::string out;
+	serializeObject(value, out);
+
+	return out;
+}
+
+
+void Serializer::serializeObject(const Mixed &value, std::string &out) {
+
+	const std::size_t size = computeSize(value);
+	const std::size_t start = out.length();
+
+	out.resize(start + size);
+
+	m_doublesPos = 0;
+	writeValue(&out[start], value);
+}
+
+
+std::size_t Serializer::valueSize(const Mixed &value) {
+
+	switch (value.type()) {
+
+		case Mixed::TYPE_NULL:
+
+			return 2;  // N;
+
+		case Mixed::TYPE_STRING: {
+
+			const std::size_t length = value.stringValue().length();
+			return 6 + unsignedLength(length) + length;  // s:<length>:"<string>";
+		}
+		case Mixed::TYPE_INT:
+
+			return 3 + integerLength(value.intValue());  // i:<value>;
+
+		case Mixed::TYPE_BOOL:
+
+			return 4;  // b:<0|1>;
+
+		case Mixed::TYPE_DOUBLE: {
+
+			char buffer[MAX_DOUBLE_LENGTH];
+			const std::size_t length = formatDouble(value.doubleValue(), buffer);
+
+			m_doubles.push_back(static_cast <char>(length));
+			m_doubles.append(buffer, length);
+
+			return 3 + length;  // d:<value>;
+		}
+		case Mixed::TYPE_ARRAY:
+
+			return arraySize(value.arrayValue());
+	}
+
+	return 0;
+}
+
+
+std::size_t Serializer::keySize(const Mixed &key, bool &converted) {
+
+	std::int64_t intKey = 0;
+	const std::string *strKey = NULL;
+
+	if (convertKey(key, intKey, strKey)) {
+
+		converted = (key.type() != Mixed::TYPE_INT);
+
+		return 3 + integerLength(intKey);  // i:<key>;
+	}
+
+	converted = (key.type() != Mixed::TYPE_STRING);
+
+	return 6 + unsignedLength(strKey->length()) + strKey->length();  // s:<length>:"<key>";
+}
+
+
+std::size_t Serializer::arraySize(const MixedArray &array) {
+
+	std::size_t size;
+
+	switch (array.type()) {
+
+		case MixedArray::TYPE_VECTOR: {
+
+			const std::vector <Mixed> &vector = array.vectorValue();
+
+			size = 5 + unsignedLength(vector.size());  // a:<count>:{}
+
+			for (std::size_t i = 0 ; i < vector.size() ; ++i) {
+				size += 3 + unsignedLength(i) + valueSize(vector[i]);
+			}
+
+			break;
+		}
+		case MixedArray::TYPE_MAP: {
+
+			const std::vector <MixedArray::Entry> &entries = array.entries();
+
+			size = 5 + unsignedLength(entries.size());
+
+			bool anyConverted = false;
+
+			for (std::size_t i = 0 ; i < entries.size() ; ++i) {
+
+				bool converted;
+
+				size += keySize(entries[i].first, converted) + valueSize(entries[i].second);
+				anyConverted = anyConverted || converted;
+			}
+
+			// Keys of a map are distinct, unless some have been converted
+			if (anyConverted) {
+				checkConvertedKeys(entries);
+			}
+
+			break;
+		}
+		default:
+
+			size = 6;  // a:0:{}
+			break;
+	}
+
+	return size;
+}
+
+
+char *Serializer::writeValue(char *p, const Mixed &value) {
+
+	switch (value.type()) {
+
+		case Mixed::TYPE_NULL:
+
+			return writeChars(p, "N;", 2);
+
+		case Mixed::TYPE_STRING: {
+
+			const std::string &str = value.stringValue();
+
+			p = writeChars(p, "s:", 2);
+			p = writeUnsigned(p, str.length());
+			p = writeChars(p, ":\"", 2);
+			p = writeChars(p, str.data(), str.length());
+			return writeChars(p, "\";", 2);
+		}
+		case Mixed::TYPE_INT:
+
+			p = writeChars(p, "i:", 2);
+			p = writeInteger(p, value.intValue());
+			*p++ = ';';
+			return p;
+
+		case Mixed::TYPE_BOOL:
+
+			return writeChars(p, value.boolValue() ? "b:1;" : "b:0;", 4);
+
+		case Mixed::TYPE_DOUBLE:
+
+			p = writeChars(p, "d:", 2);
+			p = writeDouble(p);
+			*p++ = ';';
+			return p;
+
+		case Mixed::TYPE_ARRAY:
+
+			return writeArray(p, value.arrayValue());
+	}
+
+	return p;
+}
+
+
+char *Serializer::writeKey(char *p, const Mixed &key) {
+
+	std::int64_t intKey = 0;
+	const std::string *strKey = NULL;
+
+	if (convertKey(key, intKey, strKey)) {
+
+		p = writeChars(p, "i:", 2);
+		p = writeInteger(p, intKey);
+		*p++ = ';';
+		return p;
+	}
+
+	p = writeChars(p, "s:", 2);
+	p = writeUnsigned(p, strKey->length());
+	p = writeChars(p, ":\"", 2);
+	p = writeChars(p, strKey->data(), strKey->length());
+	return writeChars(p, "\";", 2);
+}
+
+
+char *Serializer::writeArray(char *p, const MixedArray &array) {
+
+	switch (array.type()) {
+
+		case MixedArray::TYPE_VECTOR: {
+
+			const std::vector <Mixed> &vector = array.vectorValue();
+
+			p = writeChars(p, "a:", 2);
+			p = writeUnsigned(p, vector.size());
+			p = writeChars(p, ":{", 2);
+
+			for (std::size_t i = 0 ; i < vector.size() ; ++i) {
+
+				p = writeChars(p, "i:", 2);
+				p = writeUnsigned(p, i);
+				*p++ = ';';
+
+				p = writeValue(p, vector[i]);
+			}
+
+			break;
+		}
+		case MixedArray::TYPE_MAP: {
+
+			const std::vector <MixedArray::Entry> &entries = array.entries();
+
+			p = writeChars(p, "a:", 2);
+			p = writeUnsigned(p, entries.size());
+			p = writeChars(p, ":{", 2);
+
+			for (std::size_t i = 0 ; i < entries.size() ; ++i) {
+
+				p = writeKey(p, entries[i].first);
+				p = writeValue(p, entries[i].second);
+			}
+
+			break;
+		}
+		default:
+
+			p = writeChars(p, "a:0:{", 5);
+			break;
+	}
+
+	*p++ = '}';
+
+	return p;
+}
+
+
+char *Serializer::writeDouble(char *p) {
+
+	const std::size_t length = static_cast <unsigned char>(m_doubles[m_doublesPos]);
+
+	p = writeChars(p, m_doubles.data() + m_doublesPos + 1, length);
+	m_doublesPos += 1 + length;
+
+	return p;
+}
+
+
+
+std::string serialize(const Mixed &value) {
+
+	Serializer ser;
+	return ser.serializeObject(value);
+}
+
+
+} // namespace pherialize
@@ -0,0 +1,143 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_SERIALIZE_HPP_INCLUDED
+#define PHERIALIZE_SERIALIZE_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+#include "pherialize/export.hpp"
+
+#include "pherialize/Mixed.hpp"
+#include "pherialize/MixedArray.hpp"
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace pherialize {
+
+
+/** Serializes a mixed value to a string, in the format produced by
+  * PHP serialize().
+  *
+  * The exact size of the output is computed first, so that it is
+  * written into a single preallocated buffer. Doubles are written
+  * as with serialize_precision = -1 (PHP >= 7.1), that is with the
+  * shortest representation which reads back to the same value.
+  * Map elements are written in insertion order, so that data read
+  * by Unserializer is written back unchanged. Map keys are converted
+  * as PHP does: bools, doubles and strings which are the canonical
+  * form of an integer (eg. "42") are written as integers, and null
+  * as the empty string. Keys which are the same once converted are
+  * reported as an error.
+  */
+class PHERIALIZE_EXPORT Serializer {
+
+public:
+
+	Serializer();
+
+	/** Returns the size of the serialized form of a value.
+	  *
+	  * @param value value to serialize
+	  * @throw std::runtime_error if an array key cannot be serialized
+	  * @return size of the serialized data, in bytes
+	  */
+	std::size_t computeSize(const Mixed &value);
+
+	/** Serializes a value.
+	  *
+	  * @param value value to serialize
+	  * @throw std::runtime_error if an array key cannot be serialized
+	  * @return serialized data
+	  */
+	std::string serializeObject(const Mixed &value);
+
+	/** Serializes a value, appending the serialized data to a string.
+	  * Reusing the same string avoids reallocating it.
+	  *
+	  * @param value value to serialize
+	  * @param out string to which serialized data is appended
+	  * @throw std::runtime_error if an array key cannot be serialized
+	  */
+	void serializeObject(const Mixed &value, std::string &out);
+
+private:
+
+	std::size_t valueSize(const Mixed &value);
+	std::size_t keySize(const Mixed &key, bool &converted);
+	std::size_t arraySize(const MixedArray &array);
+
+	char *writeValue(char *p, const Mixed &value);
+	char *writeKey(char *p, const Mixed &key);
+	char *writeArray(char *p, const MixedArray &array);
+	char *writeDouble(char *p);
+
+
+	// Doubles formatted while computing the size, in order,
+	// and read back when writing
+	std::string m_doubles;
+	std::size_t m_doublesPos;
+};
+
+
+/** Serializes a value to a string, in the format produced by
+  * PHP serialize().
+  *
+  * @param value value to serialize
+  * @throw std::runtime_error if an array key cannot be serialized
+  * @return serialized data
+  */
+PHERIALIZE_EXPORT std::string serialize(const Mixed &value);
+
+
+/** Returns whether a string is the canonical decimal form of a 64-bit
+  * integer (no sign other than '-', no leading zero, no "-0"), which
+  * PHP converts to an integer when it is used as an array key.
+  *
+  * @param str pointer to the characters of the string
+  * @param length length of the string, in bytes
+  * @param value receives the integer value
+  * @return true if the string is an integer, or false otherwise
+  */
+PHERIALIZE_EXPORT bool stringKeyToInteger(const char *str, const std::size_t length, std::int64_t &value);
+
+
+/** Maximum length of a double formatted by formatDouble()
+  * (eg. "-1.2345678901234567E-308").
+  */
+static const std::size_t MAX_DOUBLE_LENGTH = 32;
+
+/** Formats a double as it is written in serialized data, between
+  * "d:" and ";" (see Serializer). The shortest digits are found with
+  * the Grisu3 algorithm, and with snprintf() for the rare values it
+  * cannot handle.
+  *
+  * @param value value to format
+  * @param buffer output buffer, at least MAX_DOUBLE_LENGTH bytes
+  * @return length of the formatted value, in bytes
+  */
+PHERIALIZE_EXPORT std::size_t formatDouble(const double value, char *buffer);
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_SERIALIZE_HPP_INCLUDED
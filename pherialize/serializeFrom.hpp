@@ -0,0 +1,310 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_SERIALIZEFROM_HPP_INCLUDED
+#define PHERIALIZE_SERIALIZEFROM_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+
+#include "pherialize/Descriptor.hpp"
+#include "pherialize/serialize.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/optional.hpp>
+
+
+namespace pherialize {
+namespace detail {
+
+
+inline void appendInteger(std::string &out, const std::int64_t v) {
+
+	if (v < 0) {
+		out += '-';
+		appendUnsigned(out, 0 - static_cast <std::uint64_t>(v));
+	} else {
+		appendUnsigned(out, static_cast <std::uint64_t>(v));
+	}
+}
+
+
+/** Appends the serialized form of an integer ("i:42;"). PHP integers
+  * are signed 64-bit integers.
+  */
+template <typename T>
+void encodeInteger(std::string &out, const T value) {
+
+	if (!std::numeric_limits <T>::is_signed &&
+	    static_cast <std::uint64_t>(value) > static_cast <std::uint64_t>(INT64_MAX)) {
+
+		throw std::runtime_error("Integer overflow.");
+	}
+
+	out.append("i:", 2);
+	appendInteger(out, static_cast <std::int64_t>(value));
+	out += ';';
+}
+
+
+/** Appends the serialized form of a value of type T. The primary
+  * template handles structs which have a Descriptor.
+  */
+template <typename T, typename Enable = void>
+struct TypedEncoder;
+
+
+template <typename T>
+inline void encodeTyped(std::string &out, const T &value) {
+
+	TypedEncoder <T>::encode(out, value);
+}
+
+
+/** Visitor which appends the key fragment and the value of each field.
+  */
+template <typename T>
+class FieldEncoder {
+
+public:
+
+	FieldEncoder(std::string &out, const T &object, const std::vector <std::string> &keys)
+		: m_out(out), m_object(object), m_keys(keys), m_index(0) {
+
+	}
+
+	template <typename M>
+	void field(const char *, M T::*member) {
+
+		m_out += m_keys[m_index++];
+		encodeTyped(m_out, m_object.*member);
+	}
+
+private:
+
+	std::string &m_out;
+	const T &m_object;
+	const std::vector <std::string> &m_keys;
+	std::size_t m_index;
+};
+
+
+// Structs, written as arrays with a string key per field
+template <typename T, typename Enable>
+struct TypedEncoder {
+
+	static void encode(std::string &out, const T &object) {
+
+		const StructFragments &fragments = structFragments <T>();
+
+		out += fragments.header;
+
+		FieldEncoder <T> encoder(out, object, fragments.keys);
+		Descriptor <T>::describe(encoder);
+
+		out += '}';
+	}
+};
+
+
+// Integers
+template <typename T>
+struct TypedEncoder <T, typename std::enable_if <std::is_integral <T>::value && !std::is_same <T, bool>::value>::type> {
+
+	static void encode(std::string &out, const T value) {
+
+		encodeInteger(out, value);
+	}
+};
+
+
+template <>
+struct TypedEncoder <bool> {
+
+	static void encode(std::string &out, const bool value) {
+
+		out.append(value ? "b:1;" : "b:0;", 4);
+	}
+};
+
+
+template <typename T>
+struct TypedEncoder <T, typename std::enable_if <std::is_floating_point <T>::value>::type> {
+
+	static void encode(std::string &out, const T value) {
+
+		char buffer[MAX_DOUBLE_LENGTH];
+		const std::size_t length = formatDouble(static_cast <double>(value), buffer);
+
+		out.append("d:", 2);
+		out.append(buffer, length);
+		out += ';';
+	}
+};
+
+
+template <>
+struct TypedEncoder <std::string> {
+
+	static void encode(std::string &out, const std::string &value) {
+
+		encodeString(out, value.data(), value.length());
+	}
+};
+
+
+// Arrays with keys from 0
+template <typename T, typename A>
+struct TypedEncoder <std::vector <T, A> > {
+
+	static void encode(std::string &out, const std::vector <T, A> &value) {
+
+		out.append("a:", 2);
+		appendUnsigned(out, value.size());
+		out.append(":{", 2);
+
+		for (std::size_t i = 0 ; i < value.size() ; ++i) {
+
+			encodeInteger(out, i);
+			encodeTyped(out, static_cast <const T &>(value[i]));
+		}
+
+		out += '}';
+	}
+};
+
+
+/** Appends an integer array key.
+  */
+template <typename K>
+void encodeKey(std::string &out, const K key) {
+
+	encodeInteger(out, key);
+}
+
+
+/** Appends a string array key. As in PHP, a string which is the
+  * canonical form of an integer (eg. "42") is written as an integer.
+  */
+inline void encodeKey(std::string &out, const std::string &key) {
+
+	std::int64_t intKey;
+
+	if (stringKeyToInteger(key.data(), key.length(), intKey)) {
+		encodeInteger(out, intKey);
+	} else {
+		encodeString(out, key.data(), key.length());
+	}
+}
+
+
+// Arrays with string or integer keys, in the order of the map; bool
+// keys are not accepted, as PHP does not unserialize them
+template <typename K, typename V, typename C, typename A>
+struct TypedEncoder <std::map <K, V, C, A> > {
+
+	static_assert((std::is_integral <K>::value && !std::is_same <K, bool>::value) ||
+		std::is_same <K, std::string>::value, "Array keys must be integers or strings.");
+
+	static void encode(std::string &out, const std::map <K, V, C, A> &value) {
+
+		out.append("a:", 2);
+		appendUnsigned(out, value.size());
+		out.append(":{", 2);
+
+		for (typename std::map <K, V, C, A>::const_iterator it = value.begin() ; it != value.end() ; ++it) {
+
+			encodeKey(out, it->first);
+			encodeTyped(out, it->second);
+		}
+
+		out += '}';
+	}
+};
+
+
+// Null, or a value
+template <typename T>
+struct TypedEncoder <boost::optional <T> > {
+
+	static void encode(std::string &out, const boost::optional <T> &value) {
+
+		if (value) {
+			encodeTyped(out, *value);
+		} else {
+			out.append("N;", 2);
+		}
+	}
+};
+
+
+} // namespace detail
+
+
+/** Serializes an object of type T directly, without building Mixed
+  * values, appending the serialized data to a string.
+  *
+  * T may be of any type accepted by unserializeAs(). Structs are
+  * written as arrays with a string key per field, in the order of their
+  * Descriptor; the key fragments of each struct type are computed once.
+  * An empty boost::optional is written as null. std::map keys must be
+  * integers (not bool) or strings; as in PHP, a string key which is the
+  * canonical form of an integer is written as an integer.
+  *
+  * @param value object to serialize
+  * @param out string to which serialized data is appended
+  * @throw std::runtime_error if an unsigned integer does not fit in a
+  * PHP integer
+  */
+template <typename T>
+void serializeFrom(const T &value, std::string &out) {
+
+	detail::encodeTyped(out, value);
+}
+
+
+/** Serializes an object of type T directly, without building Mixed
+  * values. See serializeFrom(const T &, std::string &).
+  *
+  * @param value object to serialize
+  * @throw std::runtime_error if an unsigned integer does not fit in a
+  * PHP integer
+  * @return serialized data
+  */
+template <typename T>
+std::string serializeFrom(const T &value) {
+
+	std::string out;
+	serializeFrom(value, out);
+
+	return out;
+}
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_SERIALIZEFROM_HPP_INCLUDED
@@ -17,331 +17,437 @@
 //
 
 #include "pherialize/unserialize.hpp"
+#include "pherialize/MappedFile.hpp"
+#include "pherialize/serialize.hpp"
 
 #include <stdexcept>
-#include <cstdlib>
-#include <istream>
-#include <sstream>
+#include <cstring>
+#include <string>
+#include <chrono>
+#include <algorithm>
 
-#include <boost/format.hpp>
+
+
+// Statistics are only recorded when an object is set, and the code
+// which records them can be left out entirely
+#ifndef PHERIALIZE_DISABLE_STATS
+#	define PHERIALIZE_STATS(...) do { if (m_stats != NULL) { __VA_ARGS__; } } while (0)
+#else
+#	define PHERIALIZE_STATS(...) do { } while (0)
+#endif
 
 
 
 namespace pherialize {
 
 
-Unserializer::Unserializer(const std::string &data) {
+#ifndef PHERIALIZE_DISABLE_STATS
+
+
+typedef std::chrono::steady_clock StatsClock;
 
-	m_pos = 0;
-	m_length = data.length();
-	m_data = data;
+
+static double secondsSince(const StatsClock::time_point start) {
+
+	return std::chrono::duration <double>(StatsClock::now() - start).count();
 }
 
 
-shared_ptr <Mixed> Unserializer::unserializeObject() {
+// Records the bytes consumed and the time spent while reading
+// a top-level object
+class Unserializer::StatsScope {
 
-	char type = m_data[m_pos];
+public:
 
-	switch (type) {
+	StatsScope(Unserializer &un)
+		: m_un(un) {
 
-		case 's':
+		if (m_un.m_stats != NULL) {
 
-			++m_pos;
-			return unserializeString();
+			m_un.m_depth = 0;
 
-		case 'i':
+			m_position = m_un.m_tokenizer.position();
+			m_start = StatsClock::now();
+		}
+	}
 
-			++m_pos;
-			return unserializeInt();
+	~StatsScope() {
 
-		case 'a':
+		if (m_un.m_stats != NULL) {
 
-			++m_pos;
-			return unserializeArray();
+			m_un.m_stats->bytes += m_un.m_tokenizer.position() - m_position;
+			m_un.m_stats->parseSeconds += secondsSince(m_start);
+		}
+	}
 
-		case 'O':
+private:
 
-			++m_pos;
-			return unserializeObjectToArray();
+	Unserializer &m_un;
+	std::size_t m_position;
+	StatsClock::time_point m_start;
+};
 
-		case 'N':
 
-			++m_pos;
-			return unserializeNull();
+static void recordNode(ParseStats &stats, const char type) {
 
-		case 'b':
+	switch (type) {
+		case 's': ++stats.nodes[Mixed::TYPE_STRING]; break;
+		case 'i': ++stats.nodes[Mixed::TYPE_INT]; break;
+		case 'b': ++stats.nodes[Mixed::TYPE_BOOL]; break;
+		case 'd': ++stats.nodes[Mixed::TYPE_DOUBLE]; break;
+		case 'N': ++stats.nodes[Mixed::TYPE_NULL]; break;
+		case 'a':
+		case 'O': ++stats.nodes[Mixed::TYPE_ARRAY]; break;
+	}
+}
 
-			++m_pos;
-			return unserializeBool();
 
-		case 'd':
+static void recordAllocation(ParseStats &stats, const std::size_t bytes) {
 
-			++m_pos;
-			return unserializeDouble();
+	++stats.allocations;
+	stats.allocatedBytes += bytes;
+}
 
-		case '\0':
 
-			return shared_ptr <Mixed>();
-	}
+static void recordString(ParseStats &stats, const std::size_t length) {
 
-	throw std::runtime_error(
-		(boost::format("Unable to unserialize unknown type '%1%'.") % type).str()
-	);
+	// Short strings are stored inline by std::string
+	static const std::size_t inlineCapacity = std::string().capacity();
+
+	if (length > inlineCapacity) {
+		recordAllocation(stats, length + 1);
+	}
 }
 
 
-shared_ptr <Mixed> Unserializer::unserializeNull() {
+static void recordKey(ParseStats &stats, const KeyDictionary::InternResult result, const std::size_t length) {
 
-	char *charAfterNumber;
-	const std::size_t number = std::strtol(m_data.data() + m_pos, &charAfterNumber, /* base */ 10);
-	m_pos = charAfterNumber - m_data.data();
+	switch (result) {
 
-	if (m_data[m_pos] != ';')
-		throw std::runtime_error("Expected ';'.");
-	else
-		m_pos++;  // skip ';'
+		case KeyDictionary::INTERN_FOUND:
 
-	return make_shared <Mixed>(false);
-}
+			break;
+
+		case KeyDictionary::INTERN_ADDED:
 
+			recordAllocation(stats, sizeof(InternedString));
+			recordString(stats, length);
+			break;
 
-shared_ptr <Mixed> Unserializer::unserializeInt() {
+		case KeyDictionary::INTERN_NOT_ADDED:
 
-	if (m_data[m_pos] != ':') {
-		throw std::runtime_error("Expected ':'.");
+			recordString(stats, length);
+			break;
 	}
+}
 
-	char *charAfterNumber;
-	const std::size_t number = std::strtol(m_data.data() + m_pos + 1, &charAfterNumber, /* base */ 10);
 
-	m_pos = charAfterNumber - m_data.data();
+#endif // PHERIALIZE_DISABLE_STATS
 
-	if (m_data[m_pos] != ';')
-		throw std::runtime_error("Expected ';'.");
-	else
-		m_pos++;  // skip ';'
 
-	return make_shared <Mixed>(static_cast <int>(number));
+Unserializer::Unserializer(const std::string &data)
+	: m_tokenizer(data.data(), data.length()), m_stats(NULL), m_depth(0), m_dictionary(NULL) {
+
 }
 
 
-shared_ptr <Mixed> Unserializer::unserializeBool() {
+Unserializer::Unserializer(const char *data, const std::size_t length)
+	: m_tokenizer(data, length), m_stats(NULL), m_depth(0), m_dictionary(NULL) {
 
-	if (m_data[m_pos] != ':') {
-		throw std::runtime_error("Expected ':'.");
-	}
+}
 
-	char *charAfterNumber;
-	const std::size_t number = std::strtol(m_data.data() + m_pos + 1, &charAfterNumber, /* base */ 10);
 
-	m_pos = charAfterNumber - m_data.data();
+void Unserializer::setStats(ParseStats *stats) {
 
-	if (m_data[m_pos] != ';')
-		throw std::runtime_error("Expected ';'.");
-	else
-		m_pos++;  // skip ';'
+	m_stats = stats;
+}
+
+
+void Unserializer::setKeyDictionary(KeyDictionary *dictionary) {
 
-	return make_shared <Mixed>(number ? true : false);
+	m_dictionary = dictionary;
 }
 
 
-shared_ptr <Mixed> Unserializer::unserializeDouble() {
+shared_ptr <Mixed> Unserializer::unserializeObject() {
 
-	if (m_data[m_pos] != ':') {
-		throw std::runtime_error("Expected ':'.");
+	if (atEnd()) {
+		return shared_ptr <Mixed>();
 	}
 
-	const char *numberStart = m_data.data() + m_pos + 1;
-	const char *numberEnd = numberStart;
+#ifndef PHERIALIZE_DISABLE_STATS
+	const StatsScope scope(*this);
+#endif
 
-	while (numberEnd < m_data.data() + m_length &&
-	       (*numberEnd == '.' || *numberEnd == '-' || *numberEnd >= '0' && *numberEnd <= '9')) {
-		++numberEnd;
-	}
+	return make_shared <Mixed>(unserializeValue());
+}
 
-	const std::string numberStr(numberStart, numberEnd);
-	std::istringstream is(numberStr);
 
-	double number;
+bool Unserializer::atEnd() const {
 
-	if (!(is >> number)) {
-		throw std::runtime_error(
-			(boost::format("Invalid format for double: '%1%'.") % numberStr).str()
-		);
+	return m_tokenizer.remaining() == 0;
+}
+
+
+bool Unserializer::unserializeObject(UnserializeHandler &handler) {
+
+	if (atEnd()) {
+		return false;
 	}
 
-	m_pos = numberEnd - m_data.data();
+#ifndef PHERIALIZE_DISABLE_STATS
+	const StatsScope scope(*this);
+#endif
 
-	if (m_data[m_pos] != ';')
-		throw std::runtime_error("Expected ';'.");
-	else
-		m_pos++;  // skip ';'
+	unserializeValue(handler);
 
-	return make_shared <Mixed>(number);
+	return true;
 }
 
 
-shared_ptr <Mixed> Unserializer::unserializeString() {
+Mixed Unserializer::unserializeValue() {
 
-	if (m_data[m_pos] != ':') {
-		throw std::runtime_error("Expected ':'.");
-	}
+	const char type = m_tokenizer.readType();
 
-	char *charAfterLen;
-	const std::size_t len = std::strtol(m_data.data() + m_pos + 1, &charAfterLen, /* base */ 10);
+	PHERIALIZE_STATS(recordNode(*m_stats, type));
 
-	if (*charAfterLen != ':') {
-		throw std::runtime_error("Expected ':'.");
-	}
+	switch (type) {
 
-	++charAfterLen;  // skip ':'
+		case 's': {
 
-	if (charAfterLen + 2 /* "..." */ + len > m_data.data() + m_length) {
-		throw std::runtime_error("Invalid string length.");
-	}
+			const char *str;
+			std::size_t length;
 
-	m_pos = (charAfterLen + 2 + len) - m_data.data();
+			m_tokenizer.readString(str, length);
 
-	if (m_data[m_pos] != ';')
-		throw std::runtime_error("Expected ';'.");
-	else
-		m_pos++;  // skip ';'
+			PHERIALIZE_STATS(recordString(*m_stats, length));
 
-	return shared_ptr <Mixed>(new Mixed(std::string(charAfterLen + 1, charAfterLen + 1 + len)));
-}
+			return Mixed(std::string(str, length));
+		}
+		case 'i':
+
+			return Mixed(m_tokenizer.readInt());
 
+		case 'a':
 
-shared_ptr <Mixed> Unserializer::unserializeObjectToArray() {
+			return unserializeArrayElements(m_tokenizer.readArrayBegin());
 
-	if (m_data[m_pos] != ':') {
-		throw std::runtime_error("Expected ':'.");
-	}
+		case 'O': {
+
+			const char *className;
+			std::size_t classNameLength;
+
+			return unserializeArrayElements(m_tokenizer.readObjectBegin(className, classNameLength));
+		}
+		case 'N':
 
-	char *charAfterCount;
-	const std::size_t count1 = std::strtol(m_data.data() + m_pos + 1, &charAfterCount, /* base */ 10);
-	const std::size_t count = std::strtol(m_data.data() + m_pos + 1 + count1 + 5, &charAfterCount, /* base */ 10);
+			m_tokenizer.readNull();
+			return Mixed();
 
-	if (*charAfterCount != ':') {
-		throw std::runtime_error("Expected ':'.");
+		case 'b':
+
+			return Mixed(m_tokenizer.readBool());
+
+		case 'd':
+
+			return Mixed(m_tokenizer.readDouble());
 	}
 
-	++charAfterCount;  // skip ':'
+	throw std::runtime_error("Unexpected end of data.");
+}
+
+
+Mixed Unserializer::unserializeKey() {
 
-	if (*charAfterCount != '{') {
-		throw std::runtime_error("Expected '{'.");
+	if (m_dictionary == NULL || m_tokenizer.peek() != 's') {
+		return unserializeValue();
 	}
 
-	++charAfterCount;  // skip '{'
+	m_tokenizer.readType();
 
-	m_pos = charAfterCount - m_data.data();
+	PHERIALIZE_STATS(recordNode(*m_stats, 's'));
 
-	// Parse elements
-	std::map <Mixed, Mixed> map;
-	std::vector <Mixed> array;
+	const char *str;
+	std::size_t length;
 
-	bool allKeysAreInteger = true;
-	bool allKeysAreConsecutive = true;
-	int previousKey = -1;
+	m_tokenizer.readString(str, length);
 
-	while (m_data[m_pos] != '\0') {
+	KeyDictionary::InternResult result;
+	Mixed key = m_dictionary->intern(str, length, &result);
 
-		if (m_data[m_pos] == '}') {
-			m_pos++;
-			break;
+	PHERIALIZE_STATS(recordKey(*m_stats, result, length));
+
+	return key;
+}
+
+
+Mixed Unserializer::unserializeArrayElements(const std::size_t count) {
+
+	// Elements are stored in a vector as long as keys are consecutive
+	// integers starting from 0. The first other key converts the
+	// elements read so far to map entries, to which the remaining
+	// ones are appended, in order.
+	std::vector <Mixed> vector;
+	std::vector <MixedArray::Entry> entries;
+
+	vector.reserve(count);
+
+	PHERIALIZE_STATS(
+		m_stats->maxDepth = std::max(m_stats->maxDepth, ++m_depth);
+
+		if (count != 0) {
+			recordAllocation(*m_stats, count * sizeof(Mixed));
 		}
+	);
+
+	bool isVector = true;
+
+	for (std::size_t i = 0 ; i < count ; ++i) {
+
+		m_tokenizer.expectElement();
+
+		Mixed key = unserializeKey();
+
+		if (isVector) {
+
+			if (key.type() == Mixed::TYPE_INT &&
+			    key.intValue() == static_cast <std::int64_t>(i)) {
 
-		shared_ptr <Mixed> key = unserializeObject();
+				vector.push_back(unserializeValue());
+				continue;
+			}
 
-		if (key->type() != Mixed::TYPE_INT) {
-			allKeysAreInteger = false;
-		} else if (key->intValue() != previousKey + 1) {
-			allKeysAreConsecutive = false;
-		} else {
-			previousKey++;
+			PHERIALIZE_STATS(recordAllocation(*m_stats, vector.capacity() * sizeof(MixedArray::Entry)));
+
+			MixedArray::convertToEntries(vector, entries);
+			isVector = false;
 		}
 
-		shared_ptr <Mixed> value = unserializeObject();
+		entries.emplace_back(std::move(key), unserializeValue());
+	}
+
+	m_tokenizer.expectArrayEnd();
 
-		array.push_back(*value);
-		map.insert(std::map <Mixed, Mixed>::value_type(*key, *value));
+	PHERIALIZE_STATS(--m_depth);
+
+	if (isVector) {
+		return Mixed(MixedArray(std::move(vector)));
 	}
 
-	if (allKeysAreInteger && allKeysAreConsecutive) {
-		return shared_ptr <Mixed>(new Mixed(MixedArray(array)));
-	} else {
-		return shared_ptr <Mixed>(new Mixed(MixedArray(map)));
+#ifndef PHERIALIZE_DISABLE_STATS
+	if (m_stats != NULL) {
+
+		const StatsClock::time_point start = StatsClock::now();
+
+		MixedArray array(std::move(entries));
+
+		m_stats->indexSeconds += secondsSince(start);
+
+		return Mixed(std::move(array));
 	}
+#endif
+
+	return Mixed(MixedArray(std::move(entries)));
 }
 
 
-shared_ptr <Mixed> Unserializer::unserializeArray() {
+void Unserializer::unserializeValue(UnserializeHandler &handler) {
 
-	if (m_data[m_pos] != ':') {
-		throw std::runtime_error("Expected ':'.");
-	}
+	std::size_t count = 0;
 
-	char *charAfterCount;
-	const std::size_t count = std::strtol(m_data.data() + m_pos + 1, &charAfterCount, /* base */ 10);
+	const char type = m_tokenizer.readType();
 
-	if (*charAfterCount != ':') {
-		throw std::runtime_error("Expected ':'.");
-	}
+	PHERIALIZE_STATS(recordNode(*m_stats, type));
 
-	++charAfterCount;  // skip ':'
+	switch (type) {
 
-	if (*charAfterCount != '{') {
-		throw std::runtime_error("Expected '{'.");
-	}
+		case 's': {
+
+			const char *str;
+			std::size_t length;
 
-	++charAfterCount;  // skip '{'
+			m_tokenizer.readString(str, length);
 
-	m_pos = charAfterCount - m_data.data();
+			handler.onString(str, length);
+			return;
+		}
+		case 'i':
 
-	// Parse elements
-	std::map <Mixed, Mixed> map;
-	std::vector <Mixed> array;
+			handler.onInt(m_tokenizer.readInt());
+			return;
 
-	bool allKeysAreInteger = true;
-	bool allKeysAreConsecutive = true;
-	int previousKey = -1;
+		case 'a':
 
-	while (m_data[m_pos] != '\0') {
+			count = m_tokenizer.readArrayBegin();
 
-		if (m_data[m_pos] == '}') {
-			m_pos++;
+			handler.onArrayBegin(count);
 			break;
-		}
 
-		shared_ptr <Mixed> key = unserializeObject();
+		case 'O': {
 
-		if (key->type() != Mixed::TYPE_INT) {
-			allKeysAreInteger = false;
-		} else if (key->intValue() != previousKey + 1) {
-			allKeysAreConsecutive = false;
-		} else {
-			previousKey++;
+			const char *className;
+			std::size_t classNameLength;
+
+			count = m_tokenizer.readObjectBegin(className, classNameLength);
+
+			handler.onObjectBegin(className, classNameLength, count);
+			break;
 		}
+		case 'N':
+
+			m_tokenizer.readNull();
+
+			handler.onNull();
+			return;
 
-		shared_ptr <Mixed> value = unserializeObject();
+		case 'b':
+
+			handler.onBool(m_tokenizer.readBool());
+			return;
+
+		case 'd':
+
+			handler.onDouble(m_tokenizer.readDouble());
+			return;
+
+		case '\0':
 
-		array.push_back(*value);
-		map.insert(std::map <Mixed, Mixed>::value_type(*key, *value));
+			throw std::runtime_error("Unexpected end of data.");
 	}
 
-	if (allKeysAreInteger && allKeysAreConsecutive) {
-		return shared_ptr <Mixed>(new Mixed(MixedArray(array)));
-	} else {
-		return shared_ptr <Mixed>(new Mixed(MixedArray(map)));
+	PHERIALIZE_STATS(m_stats->maxDepth = std::max(m_stats->maxDepth, ++m_depth));
+
+	// Array or object elements
+	for (std::size_t i = 0 ; i < count ; ++i) {
+
+		m_tokenizer.expectElement();
+
+		handler.onKey();
+
+		unserializeValue(handler);  // key
+		unserializeValue(handler);  // value
 	}
+
+	m_tokenizer.expectArrayEnd();
+
+	PHERIALIZE_STATS(--m_depth);
+
+	handler.onArrayEnd();
 }
 
 
 shared_ptr <Mixed> unserialize(const std::string &str) {
 
-	Unserializer un(str);
+	return unserialize(str.data(), str.length());
+}
+
+
+shared_ptr <Mixed> unserialize(const char *data, const std::size_t length) {
+
+	Unserializer un(data, length);
 	shared_ptr <Mixed> val = un.unserializeObject();
 
-	if (un.unserializeObject()) {
+	if (!un.atEnd()) {
 		throw std::runtime_error("Expected end of data.");
 	}
 
@@ -349,4 +455,135 @@ shared_ptr <Mixed> unserialize(const std::string &str) {
 }
 
 
+bool unserialize(const std::string &str, UnserializeHandler &handler) {
+
+	return unserialize(str.data(), str.length(), handler);
+}
+
+
+bool unserialize(const char *data, const std::size_t length, UnserializeHandler &handler) {
+
+	Unserializer un(data, length);
+
+	if (!un.unserializeObject(handler)) {
+		return false;
+	}
+
+	if (!un.atEnd()) {
+		throw std::runtime_error("Expected end of data.");
+	}
+
+	return true;
+}
+
+
+shared_ptr <Mixed> unserializeFile(const std::string &path) {
+
+	const MappedFile file(path, MappedFile::ACCESS_SEQUENTIAL);
+
+	return unserialize(file.data(), file.length());
+}
+
+
+bool unserializeFile(const std::string &path, UnserializeHandler &handler) {
+
+	const MappedFile file(path, MappedFile::ACCESS_SEQUENTIAL);
+
+	return unserialize(file.data(), file.length(), handler);
+}
+
+
+shared_ptr <Mixed> unserializePath
+	(const char *data, const std::size_t length, const std::vector <std::string> &path) {
+
+	Tokenizer tokenizer(data, length);
+
+	for (std::size_t level = 0 ; level < path.size() ; ++level) {
+
+		const std::string &element = path[level];
+
+		std::int64_t intElement = 0;
+		// A path element which is the canonical form of an integer
+		// also matches integer keys (as "42" in PHP)
+		const bool isIntElement = stringKeyToInteger(element.data(), element.length(), intElement);
+
+		std::size_t count;
+
+		switch (tokenizer.readType()) {
+
+			case 'a':
+
+				count = tokenizer.readArrayBegin();
+				break;
+
+			case 'O': {
+
+				const char *className;
+				std::size_t classNameLength;
+
+				count = tokenizer.readObjectBegin(className, classNameLength);
+				break;
+			}
+			default:
+
+				// Not an array, or no data
+				return shared_ptr <Mixed>();
+		}
+
+		bool found = false;
+
+		for (std::size_t i = 0 ; !found && i < count ; ++i) {
+
+			tokenizer.expectElement();
+
+			// Match the key, then skip the value if it does not match
+			if (tokenizer.peek() == 's') {
+
+				const char *key;
+				std::size_t keyLength;
+
+				tokenizer.readType();
+				tokenizer.readString(key, keyLength);
+
+				found = (keyLength == element.length() &&
+				         std::memcmp(key, element.data(), keyLength) == 0);
+
+			} else if (tokenizer.peek() == 'i') {
+
+				tokenizer.readType();
+
+				found = (tokenizer.readInt() == intElement && isIntElement);
+
+			} else {
+
+				tokenizer.skipValue();
+			}
+
+			if (!found) {
+				tokenizer.skipValue();
+			}
+		}
+
+		if (!found) {
+			return shared_ptr <Mixed>();
+		}
+	}
+
+	// A matched key must be followed by its value
+	if (!path.empty() && tokenizer.remaining() == 0) {
+		throw std::runtime_error("Unexpected end of data.");
+	}
+
+	Unserializer un(data + tokenizer.position(), tokenizer.remaining());
+
+	return un.unserializeObject();
+}
+
+
+shared_ptr <Mixed> unserializePath(const std::string &str, const std::vector <std::string> &path) {
+
+	return unserializePath(str.data(), str.length(), path);
+}
+
+
 } // namespace pherialize
@@ -25,8 +25,13 @@
 
 #include "pherialize/Mixed.hpp"
 #include "pherialize/MixedArray.hpp"
+#include "pherialize/Tokenizer.hpp"
+#include "pherialize/UnserializeHandler.hpp"
+#include "pherialize/ParseStats.hpp"
+#include "pherialize/KeyDictionary.hpp"
 
 #include <string>
+#include <vector>
 #include <cstddef>
 
 
@@ -40,10 +45,23 @@ class PHERIALIZE_EXPORT Unserializer {
 public:
 
 	/** Constructs a new unserializer from a character string.
+	  * The data is not copied: the string must remain valid
+	  * for the lifetime of the unserializer.
 	  *
 	  * @param data string containing serialized data
 	  */
 	Unserializer(const std::string &data);
+	Unserializer(std::string &&data) = delete;
+
+	/** Constructs a new unserializer from a caller-owned buffer.
+	  * The data is not copied: the buffer must remain valid
+	  * for the lifetime of the unserializer.
+	  *
+	  * @param data pointer to serialized data (need not be
+	  * NUL-terminated)
+	  * @param length length of data, in bytes
+	  */
+	Unserializer(const char *data, const std::size_t length);
 
 	/** Unserializes the next object from this data stream.
 	  *
@@ -53,19 +71,62 @@ public:
 	  */
 	shared_ptr <Mixed> unserializeObject();
 
+	/** Unserializes the next object from this data stream, reporting
+	  * its values to a handler instead of building Mixed values.
+	  *
+	  * @param handler handler to receive the values
+	  * @throw std::runtime_error if a parsing error occurs
+	  * @return true if an object has been read, or false if no object
+	  * can be read from the stream
+	  */
+	bool unserializeObject(UnserializeHandler &handler);
+
+	/** Returns whether all the objects have been read from this
+	  * data stream.
+	  *
+	  * @return true if no more object can be read, or false otherwise
+	  */
+	bool atEnd() const;
+
+	/** Sets the object which receives statistics on the data read by
+	  * this unserializer. When no object is set (the default), nothing
+	  * is recorded; when the library is built with PHERIALIZE_DISABLE_STATS,
+	  * the code which records statistics is not compiled at all.
+	  *
+	  * @param stats statistics to update, or NULL to stop recording;
+	  * it must remain valid while it is set
+	  */
+	void setStats(ParseStats *stats);
+
+	/** Sets a dictionary in which the string keys of arrays are
+	  * interned, when building Mixed values: keys which are already in
+	  * the dictionary are shared with the values read before, instead of
+	  * being allocated again. The dictionary may be shared by several
+	  * unserializers, in different threads.
+	  *
+	  * @param dictionary dictionary to use, or NULL to stop interning
+	  * keys (the default); it must remain valid while it is set
+	  */
+	void setKeyDictionary(KeyDictionary *dictionary);
+
 private:
 
-	shared_ptr <Mixed> unserializeNull();
-	shared_ptr <Mixed> unserializeInt();
-	shared_ptr <Mixed> unserializeBool();
-	shared_ptr <Mixed> unserializeDouble();
-	shared_ptr <Mixed> unserializeString();
-	shared_ptr <Mixed> unserializeArray();
-	shared_ptr <Mixed> unserializeObjectToArray();
-
-	std::string m_data;
-	std::size_t m_pos;
-	std::size_t m_length;
+	friend class BatchUnserializer;
+
+	class StatsScope;
+
+	Mixed unserializeValue();
+	Mixed unserializeKey();
+	Mixed unserializeArrayElements(const std::size_t count);
+
+	void unserializeValue(UnserializeHandler &handler);
+
+	Tokenizer m_tokenizer;
+
+	ParseStats *m_stats;
+	std::size_t m_depth;
+
+	KeyDictionary *m_dictionary;
 };
 
 
@@ -77,6 +138,100 @@ private:
   */
 PHERIALIZE_EXPORT shared_ptr <Mixed> unserialize(const std::string &str);
 
+/** Unserializes an object directly from a caller-owned buffer,
+  * without copying it.
+  *
+  * @param data pointer to serialized data (need not be NUL-terminated)
+  * @param length length of data, in bytes
+  * @throw std::runtime_error if a parsing error occurs
+  * @return a Mixed object, or NULL if no object can be read
+  * from the stream
+  */
+PHERIALIZE_EXPORT shared_ptr <Mixed> unserialize(const char *data, const std::size_t length);
+
+/** Unserializes an object directly from a character string, reporting
+  * its values to a handler instead of building Mixed values.
+  *
+  * @param str string containing serialized data
+  * @param handler handler to receive the values
+  * @throw std::runtime_error if a parsing error occurs
+  * @return true if an object has been read, or false if the
+  * string is empty
+  */
+PHERIALIZE_EXPORT bool unserialize(const std::string &str, UnserializeHandler &handler);
+
+/** Unserializes an object directly from a caller-owned buffer, reporting
+  * its values to a handler instead of building Mixed values.
+  *
+  * @param data pointer to serialized data (need not be NUL-terminated)
+  * @param length length of data, in bytes
+  * @param handler handler to receive the values
+  * @throw std::runtime_error if a parsing error occurs
+  * @return true if an object has been read, or false if the
+  * buffer is empty
+  */
+PHERIALIZE_EXPORT bool unserialize(const char *data, const std::size_t length, UnserializeHandler &handler);
+
+
+/** Unserializes an object from a file. The file is mapped into
+  * memory and parsed in place, instead of being read into a buffer.
+  *
+  * @param path path of the file
+  * @throw std::runtime_error if the file cannot be read, or if a
+  * parsing error occurs
+  * @return a Mixed object, or NULL if the file is empty
+  */
+PHERIALIZE_EXPORT shared_ptr <Mixed> unserializeFile(const std::string &path);
+
+/** Unserializes an object from a file, reporting its values to a
+  * handler instead of building Mixed values. The file is mapped into
+  * memory and parsed in place; strings passed to the handler point
+  * into the mapping and are only valid during the call.
+  *
+  * @param path path of the file
+  * @param handler handler to receive the values
+  * @throw std::runtime_error if the file cannot be read, or if a
+  * parsing error occurs
+  * @return true if an object has been read, or false if the
+  * file is empty
+  */
+PHERIALIZE_EXPORT bool unserializeFile(const std::string &path, UnserializeHandler &handler);
+
+/** Unserializes a single value, found by following a path of keys
+  * from the top-level array (eg. {"user", "prefs", "lang"}).
+  *
+  * The data is walked without being decoded: elements which are not
+  * on the path are skipped using string lengths and element counts,
+  * and only the target value is unserialized. Data following the target
+  * value is not read, hence not validated.
+  *
+  * A path element matches a string key with the same bytes, or an
+  * integer key if it is the canonical form of that integer (eg. "42",
+  * but not "042"), as PHP does for array keys.
+  *
+  * @param data pointer to serialized data (need not be NUL-terminated)
+  * @param length length of data, in bytes
+  * @param path keys leading to the value; if empty, the top-level
+  * value is returned
+  * @throw std::runtime_error if a parsing error occurs before the
+  * value is found
+  * @return a Mixed object, or NULL if there is no value at this path
+  */
+PHERIALIZE_EXPORT shared_ptr <Mixed> unserializePath
+	(const char *data, const std::size_t length, const std::vector <std::string> &path);
+
+/** Unserializes a single value, found by following a path of keys
+  * from the top-level array. See unserializePath(const char *,
+  * const std::size_t, const std::vector <std::string> &).
+  *
+  * @param str string containing serialized data
+  * @param path keys leading to the value
+  * @throw std::runtime_error if a parsing error occurs before the
+  * value is found
+  * @return a Mixed object, or NULL if there is no value at this path
+  */
+PHERIALIZE_EXPORT shared_ptr <Mixed> unserializePath
+	(const std::string &str, const std::vector <std::string> &path);
 
 } // namespace pherialize
 
@@ -0,0 +1,571 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_UNSERIALIZEAS_HPP_INCLUDED
+#define PHERIALIZE_UNSERIALIZEAS_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+
+#include "pherialize/Descriptor.hpp"
+#include "pherialize/Tokenizer.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/optional.hpp>
+
+
+namespace pherialize {
+namespace detail {
+
+
+inline void throwInvalidType(const char *name) {
+
+	throw std::runtime_error(
+		(boost::format("Invalid value type for '%1%'.") % name).str()
+	);
+}
+
+
+/** Reads the type tag of the next value, which must be present.
+  */
+inline char readTag(Tokenizer &tokenizer) {
+
+	const char type = tokenizer.readType();
+
+	if (type == '\0') {
+		throw std::runtime_error("Unexpected end of data.");
+	}
+
+	return type;
+}
+
+
+/** Reads the header of an array or an object, and returns its number
+  * of elements.
+  */
+inline std::size_t readArrayHeader(Tokenizer &tokenizer) {
+
+	switch (readTag(tokenizer)) {
+
+		case 'a':
+
+			return tokenizer.readArrayBegin();
+
+		case 'O': {
+
+			const char *className;
+			std::size_t classNameLength;
+
+			return tokenizer.readObjectBegin(className, classNameLength);
+		}
+	}
+
+	throwInvalidType("array");
+	return 0;
+}
+
+
+template <typename T>
+T checkIntegerRange(const std::int64_t value) {
+
+	const bool fits = std::numeric_limits <T>::is_signed
+		? (value >= static_cast <std::int64_t>(std::numeric_limits <T>::min()) &&
+		   value <= static_cast <std::int64_t>(std::numeric_limits <T>::max()))
+		: (value >= 0 &&
+		   static_cast <std::uint64_t>(value) <= static_cast <std::uint64_t>(std::numeric_limits <T>::max()));
+
+	if (!fits) {
+		throw std::runtime_error("Integer overflow.");
+	}
+
+	return static_cast <T>(value);
+}
+
+
+/** Decodes a value of type T. The primary template handles structs
+  * which have a Descriptor.
+  */
+template <typename T, typename Enable = void>
+struct TypedDecoder;
+
+
+template <typename T>
+inline void decodeTyped(Tokenizer &tokenizer, T &value) {
+
+	TypedDecoder <T>::decode(tokenizer, value);
+}
+
+
+/** Visitor which decodes the value of the field whose name matches a key.
+  * Names are only compared when their length, recorded in the fragments
+  * of the struct, is the length of the key.
+  */
+template <typename T>
+class FieldDecoder {
+
+public:
+
+	FieldDecoder(Tokenizer &tokenizer, T &object, const std::vector <std::size_t> &nameLengths,
+	             const char *key, const std::size_t keyLength)
+		: m_tokenizer(tokenizer), m_object(object), m_nameLengths(nameLengths),
+		  m_key(key), m_keyLength(keyLength), m_index(0), m_found(false) {
+
+	}
+
+	template <typename M>
+	void field(const char *name, M T::*member) {
+
+		if (!m_found && m_nameLengths[m_index++] == m_keyLength &&
+		    std::memcmp(name, m_key, m_keyLength) == 0) {
+
+			m_found = true;
+			decodeTyped(m_tokenizer, m_object.*member);
+		}
+	}
+
+	bool found() const {
+		return m_found;
+	}
+
+private:
+
+	Tokenizer &m_tokenizer;
+	T &m_object;
+	const std::vector <std::size_t> &m_nameLengths;
+	const char *m_key;
+	const std::size_t m_keyLength;
+	std::size_t m_index;
+	bool m_found;
+};
+
+
+/** Visitor which decodes the fields in the order of the descriptor,
+  * as long as the keys in the data are the expected ones. It stops
+  * before the first other key, which is not consumed.
+  */
+template <typename T>
+class OrderedFieldDecoder {
+
+public:
+
+	OrderedFieldDecoder(Tokenizer &tokenizer, T &object, const std::vector <std::string> &keys)
+		: m_tokenizer(tokenizer), m_object(object), m_keys(keys), m_decoded(0), m_matched(true) {
+
+	}
+
+	template <typename M>
+	void field(const char *, M T::*member) {
+
+		if (!m_matched) {
+			return;
+		}
+
+		const std::string &key = m_keys[m_decoded];
+
+		if (!m_tokenizer.match(key.data(), key.length())) {
+			m_matched = false;
+			return;
+		}
+
+		decodeTyped(m_tokenizer, m_object.*member);
+
+		++m_decoded;
+	}
+
+	std::size_t decoded() const {
+		return m_decoded;
+	}
+
+private:
+
+	Tokenizer &m_tokenizer;
+	T &m_object;
+	const std::vector <std::string> &m_keys;
+	std::size_t m_decoded;
+	bool m_matched;
+};
+
+
+/** Removes the visibility prefix of a property name, as written by PHP
+  * for protected ("\0*\0name") and private ("\0Class\0name") properties.
+  */
+inline void stripPropertyPrefix(const char *&key, std::size_t &length) {
+
+	if (length != 0 && key[0] == '\0') {
+
+		const void *end = std::memchr(key + 1, '\0', length - 1);
+
+		if (end != NULL) {
+
+			const std::size_t prefixLength = static_cast <const char *>(end) - key + 1;
+
+			key += prefixLength;
+			length -= prefixLength;
+		}
+	}
+}
+
+
+// Structs
+template <typename T, typename Enable>
+struct TypedDecoder {
+
+	static void decode(Tokenizer &tokenizer, T &object) {
+
+		// Fixed-shape data, such as written by serializeFrom(), has all
+		// the fields in the order of the descriptor: the header and the
+		// keys are then compared byte for byte with the expected ones,
+		// and the values are decoded as they come. The first other key
+		// falls back to matching each remaining key against the fields;
+		// values already decoded are kept, so nothing is read twice.
+		const StructFragments &fragments = structFragments <T>();
+
+		if (tokenizer.match(fragments.header.data(), fragments.header.length())) {
+
+			OrderedFieldDecoder <T> decoder(tokenizer, object, fragments.keys);
+			Descriptor <T>::describe(decoder);
+
+			decodeFields(tokenizer, object, fragments.keys.size() - decoder.decoded());
+
+		} else {
+
+			decodeFields(tokenizer, object, readArrayHeader(tokenizer));
+		}
+	}
+
+private:
+
+	static void decodeFields(Tokenizer &tokenizer, T &object, const std::size_t count) {
+
+		const std::vector <std::size_t> &nameLengths = structFragments <T>().nameLengths;
+
+		for (std::size_t i = 0 ; i < count ; ++i) {
+
+			tokenizer.expectElement();
+
+			// Only string keys may name a field; the values of unknown
+			// keys are skipped
+			if (tokenizer.peek() == 's') {
+
+				const char *key;
+				std::size_t keyLength;
+
+				tokenizer.readType();
+				tokenizer.readString(key, keyLength);
+
+				stripPropertyPrefix(key, keyLength);
+
+				FieldDecoder <T> decoder(tokenizer, object, nameLengths, key, keyLength);
+				Descriptor <T>::describe(decoder);
+
+				if (!decoder.found()) {
+					tokenizer.skipValue();
+				}
+
+			} else {
+
+				tokenizer.skipValue();
+				tokenizer.skipValue();
+			}
+		}
+
+		tokenizer.expectArrayEnd();
+	}
+};
+
+
+// Integers
+template <typename T>
+struct TypedDecoder <T, typename std::enable_if <std::is_integral <T>::value && !std::is_same <T, bool>::value>::type> {
+
+	static void decode(Tokenizer &tokenizer, T &value) {
+
+		if (readTag(tokenizer) != 'i') {
+			throwInvalidType("int");
+		}
+
+		value = checkIntegerRange <T>(tokenizer.readInt());
+	}
+};
+
+
+template <>
+struct TypedDecoder <bool> {
+
+	static void decode(Tokenizer &tokenizer, bool &value) {
+
+		if (readTag(tokenizer) != 'b') {
+			throwInvalidType("bool");
+		}
+
+		value = tokenizer.readBool();
+	}
+};
+
+
+// Integers are also accepted, as a PHP variable may hold an int or a
+// float depending on how it has been computed
+template <typename T>
+struct TypedDecoder <T, typename std::enable_if <std::is_floating_point <T>::value>::type> {
+
+	static void decode(Tokenizer &tokenizer, T &value) {
+
+		switch (readTag(tokenizer)) {
+
+			case 'd':
+
+				value = static_cast <T>(tokenizer.readDouble());
+				return;
+
+			case 'i':
+
+				value = static_cast <T>(tokenizer.readInt());
+				return;
+		}
+
+		throwInvalidType("double");
+	}
+};
+
+
+template <>
+struct TypedDecoder <std::string> {
+
+	static void decode(Tokenizer &tokenizer, std::string &value) {
+
+		if (readTag(tokenizer) != 's') {
+			throwInvalidType("string");
+		}
+
+		const char *str;
+		std::size_t length;
+
+		tokenizer.readString(str, length);
+
+		value.assign(str, length);
+	}
+};
+
+
+// Values of an array, in order; keys are ignored
+template <typename T, typename A>
+struct TypedDecoder <std::vector <T, A> > {
+
+	static void decode(Tokenizer &tokenizer, std::vector <T, A> &value) {
+
+		const std::size_t count = readArrayHeader(tokenizer);
+
+		value.clear();
+		value.reserve(count);
+
+		for (std::size_t i = 0 ; i < count ; ++i) {
+
+			tokenizer.expectElement();
+			tokenizer.skipValue();
+
+			T element;
+			decodeTyped(tokenizer, element);
+
+			value.push_back(std::move(element));
+		}
+
+		tokenizer.expectArrayEnd();
+	}
+};
+
+
+/** Decodes an array key. Integer keys are accepted for string keys, as
+  * PHP converts numeric string keys to integers.
+  */
+template <typename K, typename Enable = void>
+struct TypedKeyDecoder {
+
+	static void decode(Tokenizer &tokenizer, K &key) {
+
+		decodeTyped(tokenizer, key);
+	}
+};
+
+
+template <>
+struct TypedKeyDecoder <std::string> {
+
+	static void decode(Tokenizer &tokenizer, std::string &key) {
+
+		if (tokenizer.peek() == 'i') {
+
+			tokenizer.readType();
+			key = boost::lexical_cast <std::string>(tokenizer.readInt());
+
+		} else {
+
+			decodeTyped(tokenizer, key);
+		}
+	}
+};
+
+
+// Keys and values of an array; for duplicate keys, the first one is kept
+template <typename K, typename V, typename C, typename A>
+struct TypedDecoder <std::map <K, V, C, A> > {
+
+	static void decode(Tokenizer &tokenizer, std::map <K, V, C, A> &value) {
+
+		const std::size_t count = readArrayHeader(tokenizer);
+
+		value.clear();
+
+		for (std::size_t i = 0 ; i < count ; ++i) {
+
+			tokenizer.expectElement();
+
+			K key;
+			TypedKeyDecoder <K>::decode(tokenizer, key);
+
+			V element;
+			decodeTyped(tokenizer, element);
+
+			value.insert(std::make_pair(std::move(key), std::move(element)));
+		}
+
+		tokenizer.expectArrayEnd();
+	}
+};
+
+
+// Null, or a value
+template <typename T>
+struct TypedDecoder <boost::optional <T> > {
+
+	static void decode(Tokenizer &tokenizer, boost::optional <T> &value) {
+
+		if (tokenizer.peek() == 'N') {
+
+			tokenizer.readType();
+			tokenizer.readNull();
+
+			value = boost::none;
+
+		} else {
+
+			T v;
+			decodeTyped(tokenizer, v);
+
+			value = std::move(v);
+		}
+	}
+};
+
+
+} // namespace detail
+
+
+/** Unserializes a value directly into an object of type T, without
+  * building Mixed values.
+  *
+  * T may be an integer, bool, double or string type, std::vector (the
+  * values of a PHP array, in order), std::map, boost::optional (NULL
+  * for PHP null), or a struct which has a Descriptor. Keys which do not
+  * match a field of a struct are skipped, and fields which are not in
+  * the data keep their value. The types of the values must otherwise
+  * match: no conversion is made, except from int to double.
+  *
+  * @param data pointer to serialized data (need not be NUL-terminated)
+  * @param length length of data, in bytes
+  * @param value object to receive the value
+  * @throw std::runtime_error if a parsing error occurs, or if the data
+  * does not match type T
+  */
+template <typename T>
+void unserializeInto(const char *data, const std::size_t length, T &value) {
+
+	Tokenizer tokenizer(data, length);
+
+	detail::decodeTyped(tokenizer, value);
+
+	if (tokenizer.remaining() != 0) {
+		throw std::runtime_error("Expected end of data.");
+	}
+}
+
+
+/** Unserializes a value directly into an object of type T, without
+  * building Mixed values. See unserializeInto().
+  *
+  * @param str string containing serialized data
+  * @param value object to receive the value
+  * @throw std::runtime_error if a parsing error occurs, or if the data
+  * does not match type T
+  */
+template <typename T>
+void unserializeInto(const std::string &str, T &value) {
+
+	unserializeInto(str.data(), str.length(), value);
+}
+
+
+/** Unserializes a value directly to type T, which must be default
+  * constructible. See unserializeInto().
+  *
+  * @param data pointer to serialized data (need not be NUL-terminated)
+  * @param length length of data, in bytes
+  * @throw std::runtime_error if a parsing error occurs, or if the data
+  * does not match type T
+  * @return unserialized value
+  */
+template <typename T>
+T unserializeAs(const char *data, const std::size_t length) {
+
+	T value = T();
+	unserializeInto(data, length, value);
+
+	return value;
+}
+
+
+/** Unserializes a value directly to type T, which must be default
+  * constructible. See unserializeInto().
+  *
+  * @param str string containing serialized data
+  * @throw std::runtime_error if a parsing error occurs, or if the data
+  * does not match type T
+  * @return unserialized value
+  */
+template <typename T>
+T unserializeAs(const std::string &str) {
+
+	return unserializeAs <T>(str.data(), str.length());
+}
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_UNSERIALIZEAS_HPP_INCLUDED
@@ -0,0 +1,399 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#include "pherialize/validate.hpp"
+
+#include <cstring>
+#include <cstdint>
+
+
+
+namespace pherialize {
+
+
+/** Skips a run of ASCII digits. Digits are checked 8 bytes at a time
+  * (SWAR): a byte b is a digit if it is below 0x80 and if adding
+  * 0x46 and 0x50 to its low 7 bits respectively leaves and sets the
+  * high bit, that is if 0x30 <= b < 0x3A.
+  *
+  * @param p first character
+  * @param end end of data
+  * @return pointer to the first character which is not a digit
+  */
+static const char *skipDigits(const char *p, const char *end) {
+
+	const std::uint64_t high = 0x8080808080808080ULL;
+	const std::uint64_t low = 0x7F7F7F7F7F7F7F7FULL;
+
+	while (end - p >= 8) {
+
+		std::uint64_t v;
+		std::memcpy(&v, p, sizeof(v));
+
+		const std::uint64_t aboveNine = (v & low) + 0x4646464646464646ULL;
+		const std::uint64_t atLeastZero = (v & low) + 0x5050505050505050ULL;
+
+		if (((v | aboveNine | ~atLeastZero) & high) != 0) {
+			break;
+		}
+
+		p += 8;
+	}
+
+	while (p < end && *p >= '0' && *p <= '9') {
+		++p;
+	}
+
+	return p;
+}
+
+
+/** Single-pass validator. Nothing is allocated: on error, the
+  * position and a static message are recorded.
+  */
+class Validator {
+
+public:
+
+	Validator(const char *data, const std::size_t length, const std::size_t maxDepth)
+		: m_begin(data), m_p(data), m_end(data + length), m_maxDepth(maxDepth),
+		  m_error(NULL), m_errorPos(data) {
+
+	}
+
+	bool validateObject() {
+
+		return validateValue(0) && (m_p == m_end || fail("Expected end of data."));
+	}
+
+	bool validatePrefix() {
+
+		return validateValue(0);
+	}
+
+	std::size_t position() const {
+
+		return static_cast <std::size_t>(m_p - m_begin);
+	}
+
+	ValidationResult result() const {
+
+		ValidationResult res;
+
+		res.valid = (m_error == NULL);
+		res.errorOffset = res.valid ? 0 : static_cast <std::size_t>(m_errorPos - m_begin);
+		res.errorMessage = m_error;
+
+		return res;
+	}
+
+private:
+
+	bool fail(const char *message) {
+
+		m_error = message;
+		m_errorPos = m_p;
+
+		return false;
+	}
+
+	bool expect(const char c) {
+
+		if (m_p == m_end || *m_p != c) {
+
+			switch (c) {
+				case ':': return fail("Expected ':'.");
+				case ';': return fail("Expected ';'.");
+				case '{': return fail("Expected '{'.");
+				case '}': return fail("Expected '}'.");
+				case '"': return fail("Expected '\"'.");
+			}
+
+			return fail("Unexpected character.");
+		}
+
+		++m_p;
+		return true;
+	}
+
+	/** Checks a signed decimal integer which fits in 64 bits. If value
+	  * is not NULL, the integer is also decoded.
+	  */
+	bool integer(std::int64_t *value) {
+
+		bool negative = false;
+
+		if (m_p < m_end && (*m_p == '-' || *m_p == '+')) {
+			negative = (*m_p == '-');
+			++m_p;
+		}
+
+		const char *start = m_p;
+
+		// Leading zeros do not count towards the range
+		while (m_p < m_end && *m_p == '0') {
+			++m_p;
+		}
+
+		const char *significant = m_p;
+
+		m_p = skipDigits(m_p, m_end);
+
+		if (m_p == start) {
+			return fail("Expected number.");
+		}
+
+		const std::size_t digits = m_p - significant;
+
+		if (digits > 19 || (digits == 19 && std::memcmp(significant,
+				negative ? "9223372036854775808" : "9223372036854775807", 19) > 0)) {
+
+			m_p = significant;
+			return fail("Integer overflow.");
+		}
+
+		if (value != NULL) {
+
+			std::uint64_t number = 0;
+
+			for (const char *d = significant ; d != m_p ; ++d) {
+				number = number * 10 + (*d - '0');
+			}
+
+			*value = (negative && number != 0)
+				? -static_cast <std::int64_t>(number - 1) - 1
+				: static_cast <std::int64_t>(number);
+		}
+
+		return true;
+	}
+
+	bool length(std::size_t &len) {
+
+		const char *start = m_p;
+		std::int64_t value;
+
+		if (!integer(&value)) {
+			return false;
+		}
+
+		if (value < 0 || static_cast <std::uint64_t>(value) > SIZE_MAX) {
+			m_p = start;
+			return fail("Invalid length.");
+		}
+
+		len = static_cast <std::size_t>(value);
+		return true;
+	}
+
+	bool count(std::size_t &n) {
+
+		const char *start = m_p;
+
+		if (!length(n)) {
+			return false;
+		}
+
+		// Same bound as Tokenizer: each element takes at least 4 characters
+		if (n > static_cast <std::size_t>(m_end - m_p) / 4) {
+			m_p = start;
+			return fail("Invalid element count.");
+		}
+
+		return true;
+	}
+
+	bool quoted(const std::size_t len) {
+
+		if (len + 2 > static_cast <std::size_t>(m_end - m_p)) {
+			return fail("Invalid string length.");
+		}
+
+		if (!expect('"')) {
+			return false;
+		}
+
+		m_p += len;
+
+		return expect('"');
+	}
+
+	bool number() {
+
+		const char *start = m_p;
+
+		if (m_p < m_end && (*m_p == '-' || *m_p == '+')) {
+			++m_p;
+		}
+
+		if (m_end - m_p >= 3 && std::memcmp(m_p, "INF", 3) == 0) {
+			m_p += 3;
+			return true;
+		}
+
+		if (m_p == start && m_end - m_p >= 3 && std::memcmp(m_p, "NAN", 3) == 0) {
+			m_p += 3;
+			return true;
+		}
+
+		const char *digitsStart = m_p;
+
+		m_p = skipDigits(m_p, m_end);
+
+		bool anyDigit = (m_p != digitsStart);
+
+		if (m_p < m_end && *m_p == '.') {
+
+			const char *fraction = ++m_p;
+
+			m_p = skipDigits(m_p, m_end);
+			anyDigit = anyDigit || (m_p != fraction);
+		}
+
+		if (!anyDigit) {
+			return fail("Invalid format for double.");
+		}
+
+		if (m_p < m_end && (*m_p == 'e' || *m_p == 'E')) {
+
+			++m_p;
+
+			if (m_p < m_end && (*m_p == '-' || *m_p == '+')) {
+				++m_p;
+			}
+
+			const char *exponent = m_p;
+
+			m_p = skipDigits(m_p, m_end);
+
+			if (m_p == exponent) {
+				return fail("Invalid format for double.");
+			}
+		}
+
+		return true;
+	}
+
+	bool elements(const std::size_t n, const std::size_t depth) {
+
+		for (std::size_t i = 0 ; i < n ; ++i) {
+
+			if (m_p < m_end && *m_p == '}') {
+				return fail("Element count mismatch.");
+			}
+
+			if (!validateValue(depth + 1) || !validateValue(depth + 1)) {
+				return false;
+			}
+		}
+
+		if (m_p == m_end || *m_p != '}') {
+			return fail(m_p == m_end ? "Unexpected end of data." : "Element count mismatch.");
+		}
+
+		++m_p;
+		return true;
+	}
+
+	bool validateValue(const std::size_t depth) {
+
+		if (m_p == m_end) {
+			return fail("Unexpected end of data.");
+		}
+
+		std::size_t len, n;
+
+		if ((*m_p == 'a' || *m_p == 'O') && depth + 1 > m_maxDepth) {
+			return fail("Maximum depth exceeded.");
+		}
+
+		switch (*m_p++) {
+
+			case 'N':
+
+				return expect(';');
+
+			case 'i':
+			case 'b':
+
+				return expect(':') && integer(NULL) && expect(';');
+
+			case 'd':
+
+				return expect(':') && number() && expect(';');
+
+			case 's':
+
+				return expect(':') && length(len) && expect(':') && quoted(len) && expect(';');
+
+			case 'a':
+
+				return expect(':') && count(n) && expect(':') && expect('{') && elements(n, depth);
+
+			case 'O':
+
+				return expect(':') && length(len) && expect(':') && quoted(len) &&
+				       expect(':') && count(n) && expect(':') && expect('{') && elements(n, depth);
+		}
+
+		--m_p;
+		return fail("Unknown type.");
+	}
+
+
+	const char *m_begin;
+	const char *m_p;
+	const char *m_end;
+	const std::size_t m_maxDepth;
+
+	const char *m_error;
+	const char *m_errorPos;
+};
+
+
+
+ValidationResult validate(const char *data, const std::size_t length, const std::size_t maxDepth) {
+
+	Validator validator(data, length, maxDepth);
+
+	if (length != 0) {
+		validator.validateObject();
+	}
+
+	return validator.result();
+}
+
+
+ValidationResult validate(const std::string &str, const std::size_t maxDepth) {
+
+	return validate(str.data(), str.length(), maxDepth);
+}
+
+
+ValidationResult validatePrefix
+	(const char *data, const std::size_t length, std::size_t &valueLength, const std::size_t maxDepth) {
+
+	Validator validator(data, length, maxDepth);
+
+	valueLength = validator.validatePrefix() ? validator.position() : 0;
+
+	return validator.result();
+}
+
+
+} // namespace pherialize
@@ -0,0 +1,99 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#ifndef PHERIALIZE_VALIDATE_HPP_INCLUDED
+#define PHERIALIZE_VALIDATE_HPP_INCLUDED
+
+
+#include "pherialize/types.hpp"
+#include "pherialize/export.hpp"
+
+#include <string>
+#include <cstddef>
+
+
+namespace pherialize {
+
+
+/** Result of the validation of serialized data.
+  */
+struct PHERIALIZE_EXPORT ValidationResult {
+
+	/** Whether the data is valid. */
+	bool valid;
+
+	/** Offset of the first invalid character, if the data is not valid. */
+	std::size_t errorOffset;
+
+	/** Description of the error (a static string), or NULL if the
+	  * data is valid. */
+	const char *errorMessage;
+};
+
+
+/** Default maximum nesting depth of arrays accepted by validate(). */
+static const std::size_t DEFAULT_MAX_VALIDATION_DEPTH = 512;
+
+
+/** Checks that data can be unserialized, without unserializing it.
+  *
+  * The data is checked in a single pass, and no memory is allocated:
+  * type tags, delimiters, string lengths, integer ranges, double syntax,
+  * declared element counts and nesting depth are verified as
+  * unserialize() would. Empty data is valid (unserialize() returns NULL),
+  * and a NUL character is never taken as the end of data.
+  *
+  * @param data pointer to serialized data (need not be NUL-terminated)
+  * @param length length of data, in bytes
+  * @param maxDepth maximum nesting depth of arrays and objects
+  * @return validation result
+  */
+PHERIALIZE_EXPORT ValidationResult validate
+	(const char *data, const std::size_t length,
+	 const std::size_t maxDepth = DEFAULT_MAX_VALIDATION_DEPTH);
+
+/** Checks that data can be unserialized, without unserializing it.
+  * See validate(const char *, const std::size_t, const std::size_t).
+  *
+  * @param str string containing serialized data
+  * @param maxDepth maximum nesting depth of arrays and objects
+  * @return validation result
+  */
+PHERIALIZE_EXPORT ValidationResult validate
+	(const std::string &str, const std::size_t maxDepth = DEFAULT_MAX_VALIDATION_DEPTH);
+
+/** Checks the value at the start of data, which may be followed by
+  * other data (eg. the next element of an array), and returns its
+  * length. Unlike validate(), empty data is not valid.
+  *
+  * @param data pointer to serialized data (need not be NUL-terminated)
+  * @param length length of data, in bytes
+  * @param valueLength will receive the length of the value, in bytes,
+  * or 0 if it is not valid
+  * @param maxDepth maximum nesting depth of arrays and objects
+  * @return validation result
+  */
+PHERIALIZE_EXPORT ValidationResult validatePrefix
+	(const char *data, const std::size_t length, std::size_t &valueLength,
+	 const std::size_t maxDepth = DEFAULT_MAX_VALIDATION_DEPTH);
+
+
+} // namespace pherialize
+
+
+#endif // PHERIALIZE_VALIDATE_HPP_INCLUDED
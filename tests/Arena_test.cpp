@@ -0,0 +1,62 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#define BOOST_TEST_MODULE pherialize_Arena test
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "pherialize/Arena.hpp"
+
+#include <cstring>
+
+
+using namespace pherialize;
+
+
+BOOST_AUTO_TEST_CASE(Arena_allocate) {
+
+	Arena arena(64);
+	BOOST_CHECK_EQUAL(0, arena.capacity());
+
+	// Small allocations are carved from the same block
+	char *p1 = static_cast <char *>(arena.allocate(10, 1));
+	char *p2 = static_cast <char *>(arena.allocate(10, 1));
+	BOOST_CHECK(p2 == p1 + 10);
+
+	std::memset(p1, 'a', 10);
+	std::memset(p2, 'b', 10);
+
+	// Alignment is honored
+	double *d = arena.allocateArray <double>(3);
+	BOOST_CHECK_EQUAL(0, reinterpret_cast <std::size_t>(d) % alignof(double));
+
+	// Allocation larger than a block
+	char *p3 = static_cast <char *>(arena.allocate(1000, 1));
+	std::memset(p3, 'c', 1000);
+	BOOST_CHECK(arena.capacity() >= 1000);
+
+	BOOST_CHECK_EQUAL('a', p1[9]);
+	BOOST_CHECK_EQUAL('b', p2[0]);
+
+	// Release all
+	arena.clear();
+	BOOST_CHECK_EQUAL(0, arena.capacity());
+
+	char *p4 = static_cast <char *>(arena.allocate(10, 1));
+	BOOST_CHECK(p4 != NULL);
+}
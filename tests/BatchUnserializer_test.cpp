@@ -0,0 +1,294 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#define BOOST_TEST_MODULE pherialize_BatchUnserializer test
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "pherialize/BatchUnserializer.hpp"
+#include "pherialize/unserialize.hpp"
+
+#include <string>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+
+using namespace pherialize;
+
+
+// Returns "a:N:{i:0;i:0;...}": inputs of very different sizes
+// exercise the stealing of work between threads
+static std::string makeArray(const int count) {
+
+	std::string str = "a:" + boost::lexical_cast <std::string>(count) + ":{";
+
+	for (int i = 0 ; i < count ; ++i) {
+		const std::string n = boost::lexical_cast <std::string>(i);
+		str += "i:" + n + ";i:" + n + ";";
+	}
+
+	return str + "}";
+}
+
+
+BOOST_AUTO_TEST_CASE(batchResults) {
+
+	BatchUnserializer batch(4);
+
+	BOOST_CHECK_EQUAL(4, batch.threadCount());
+
+	std::vector <std::string> inputs;
+	inputs.push_back("i:42;");
+	inputs.push_back("s:3:\"foo\";");
+	inputs.push_back("");
+	inputs.push_back("a:1:{s:1:\"k\";b:1;}");
+
+	const std::vector <BatchResult> results = batch.unserializeBatch(inputs);
+
+	BOOST_REQUIRE_EQUAL(4, results.size());
+
+	BOOST_CHECK(results[0].ok);
+	BOOST_CHECK_EQUAL(42, results[0].value->intValue());
+	BOOST_CHECK(results[1].ok);
+	BOOST_CHECK_EQUAL("foo", results[1].value->stringValue());
+	BOOST_CHECK(results[2].ok);
+	BOOST_CHECK(!results[2].value);
+	BOOST_CHECK(results[3].ok);
+	BOOST_CHECK_EQUAL(true, results[3].value->arrayValue().find("k")->boolValue());
+}
+
+
+BOOST_AUTO_TEST_CASE(batchErrors) {
+
+	BatchUnserializer batch(3);
+
+	std::vector <std::string> inputs;
+	inputs.push_back("i:1;");
+	inputs.push_back("i:1");
+	inputs.push_back("a:2:{i:0;i:0;}");
+	inputs.push_back("i:2;");
+	inputs.push_back("i:1;i:2;");
+
+	const std::vector <BatchResult> results = batch.unserializeBatch(inputs);
+
+	BOOST_REQUIRE_EQUAL(5, results.size());
+
+	BOOST_CHECK(results[0].ok);
+	BOOST_CHECK(results[0].error.empty());
+	BOOST_CHECK(!results[1].ok);
+	BOOST_CHECK(!results[1].value);
+	BOOST_CHECK(!results[1].error.empty());
+	BOOST_CHECK(!results[2].ok);
+	BOOST_CHECK_EQUAL("Element count mismatch.", results[2].error);
+	BOOST_CHECK(results[3].ok);
+	BOOST_CHECK_EQUAL(2, results[3].value->intValue());
+	BOOST_CHECK(!results[4].ok);
+	BOOST_CHECK_EQUAL("Expected end of data.", results[4].error);
+}
+
+
+BOOST_AUTO_TEST_CASE(batchSkewed) {
+
+	BatchUnserializer batch(4);
+
+	// All large inputs go to the first worker initially
+	std::vector <std::string> inputs;
+
+	for (int i = 0 ; i < 200 ; ++i) {
+		inputs.push_back(i < 20 ? makeArray(2000 + i) : makeArray(i % 5));
+	}
+
+	const std::vector <BatchResult> results = batch.unserializeBatch(inputs);
+
+	BOOST_REQUIRE_EQUAL(200, results.size());
+
+	for (int i = 0 ; i < 200 ; ++i) {
+
+		BOOST_REQUIRE(results[i].ok);
+		BOOST_CHECK_EQUAL(i < 20 ? 2000 + i : i % 5, results[i].value->arrayValue().size());
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(batchReuse) {
+
+	BatchUnserializer batch(2);
+
+	for (int n = 0 ; n < 100 ; ++n) {
+
+		std::vector <BatchInput> inputs;
+		std::vector <std::string> strings;
+
+		for (int i = 0 ; i < n ; ++i) {
+			strings.push_back("i:" + boost::lexical_cast <std::string>(n * 1000 + i) + ";");
+		}
+
+		for (int i = 0 ; i < n ; ++i) {
+
+			BatchInput input;
+			input.data = strings[i].data();
+			input.length = strings[i].length();
+
+			inputs.push_back(input);
+		}
+
+		const std::vector <BatchResult> results = batch.unserializeBatch(inputs.data(), inputs.size());
+
+		BOOST_REQUIRE_EQUAL(n, results.size());
+
+		for (int i = 0 ; i < n ; ++i) {
+			BOOST_CHECK_EQUAL(n * 1000 + i, results[i].value->intValue());
+		}
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(batchSingleThread) {
+
+	BatchUnserializer batch(1);
+
+	BOOST_CHECK_EQUAL(1, batch.threadCount());
+
+	std::vector <std::string> inputs(10, "b:0;");
+
+	const std::vector <BatchResult> results = batch.unserializeBatch(inputs);
+
+	BOOST_REQUIRE_EQUAL(10, results.size());
+
+	for (std::size_t i = 0 ; i < results.size() ; ++i) {
+		BOOST_CHECK_EQUAL(false, results[i].value->boolValue());
+	}
+
+	BOOST_CHECK(BatchUnserializer().threadCount() >= 1);
+}
+
+
+// Unserializes with both functions, and checks that they give the
+// same value or the same error
+static void checkParallel(BatchUnserializer &batch, const std::string &data) {
+
+	shared_ptr <Mixed> expected;
+	std::string expectedError;
+
+	try {
+		expected = unserialize(data);
+	} catch (std::runtime_error &e) {
+		expectedError = e.what();
+	}
+
+	shared_ptr <Mixed> actual;
+	std::string actualError;
+
+	try {
+		actual = batch.unserializeParallel(data);
+	} catch (std::runtime_error &e) {
+		actualError = e.what();
+	}
+
+	BOOST_CHECK_EQUAL(expectedError, actualError);
+	BOOST_REQUIRE_EQUAL(!expected, !actual);
+
+	if (expected) {
+		BOOST_CHECK(*expected == *actual);
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(parallelVector) {
+
+	BatchUnserializer batch(4);
+
+	const std::string data = makeArray(5000);
+	const shared_ptr <Mixed> val = batch.unserializeParallel(data);
+
+	BOOST_REQUIRE(val);
+	BOOST_CHECK_EQUAL(MixedArray::TYPE_VECTOR, val->arrayValue().type());
+	BOOST_CHECK_EQUAL(5000, val->arrayValue().size());
+	BOOST_CHECK_EQUAL(4321, val->arrayValue().find(4321)->intValue());
+
+	checkParallel(batch, data);
+}
+
+
+BOOST_AUTO_TEST_CASE(parallelMap) {
+
+	BatchUnserializer batch(3);
+
+	// Records with string keys, nested arrays and strings containing
+	// delimiters, which the scan must skip using their length
+	std::string data = "a:3000:{";
+
+	for (int i = 0 ; i < 3000 ; ++i) {
+
+		const std::string n = boost::lexical_cast <std::string>(i);
+		const std::string str = "}\"a:1:{" + n;
+
+		data += "s:" + boost::lexical_cast <std::string>(n.length() + 2) + ":\"id" + n + "\";";
+		data += "a:2:{s:4:\"name\";s:" + boost::lexical_cast <std::string>(str.length())
+			+ ":\"" + str + "\";s:5:\"score\";d:" + n + ".5;}";
+	}
+
+	data += "}";
+
+	const shared_ptr <Mixed> val = batch.unserializeParallel(data);
+
+	BOOST_REQUIRE(val);
+	BOOST_CHECK_EQUAL(MixedArray::TYPE_MAP, val->arrayValue().type());
+	BOOST_CHECK_EQUAL("}\"a:1:{17", val->arrayValue().find("id17")->arrayValue().find("name")->stringValue());
+	BOOST_CHECK_EQUAL(2999.5, val->arrayValue().find("id2999")->arrayValue().find("score")->doubleValue());
+
+	checkParallel(batch, data);
+
+	// Integer keys which are not consecutive, and objects
+	std::string data2 = "O:8:\"stdClass\":2000:{";
+
+	for (int i = 0 ; i < 2000 ; ++i) {
+		data2 += "i:" + boost::lexical_cast <std::string>(i == 1000 ? 0 : i) + ";b:1;";
+	}
+
+	checkParallel(batch, data2 + "}");
+}
+
+
+BOOST_AUTO_TEST_CASE(parallelFallback) {
+
+	BatchUnserializer batch(2);
+
+	const std::string data = makeArray(2000);
+
+	checkParallel(batch, "");
+	checkParallel(batch, "i:42;");
+	checkParallel(batch, makeArray(10));
+
+	// Invalid data gives the same errors as unserialize()
+	checkParallel(batch, data + "i:1;");
+	checkParallel(batch, data.substr(0, data.length() - 1));
+	checkParallel(batch, data.substr(0, data.length() / 2));
+	checkParallel(batch, "a:2000" + data.substr(6, data.length() - 6 - 8) + "}");
+
+	std::string corrupt = data;
+	corrupt[corrupt.length() / 2] = 'x';
+
+	checkParallel(batch, corrupt);
+
+	// Single thread
+	BatchUnserializer single(1);
+
+	checkParallel(single, data);
+}
@@ -0,0 +1,134 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#define BOOST_TEST_MODULE pherialize_Document test
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "pherialize/Document.hpp"
+#include "pherialize/unserialize.hpp"
+
+
+using namespace pherialize;
+
+
+BOOST_AUTO_TEST_CASE(Document_empty) {
+
+	Document doc;
+	BOOST_CHECK(doc.empty());
+	BOOST_CHECK(doc.root().isNull());
+
+	doc.parse("");
+	BOOST_CHECK(doc.empty());
+}
+
+
+BOOST_AUTO_TEST_CASE(Document_scalars) {
+
+	Document doc;
+
+	doc.parse("s:11:\"test string\";");
+	BOOST_CHECK_EQUAL(Mixed::TYPE_STRING, doc.root().type());
+	BOOST_CHECK_EQUAL("test string", doc.root().stringValue());
+	BOOST_CHECK_EQUAL(11, doc.root().stringLength());
+
+	doc.parse("i:4242;");
+	BOOST_CHECK_EQUAL(Mixed::TYPE_INT, doc.root().type());
+	BOOST_CHECK_EQUAL(4242, doc.root().intValue());
+
+	doc.parse("b:1;");
+	BOOST_CHECK_EQUAL(Mixed::TYPE_BOOL, doc.root().type());
+	BOOST_CHECK_EQUAL(true, doc.root().boolValue());
+
+	doc.parse("d:-0.05;");
+	BOOST_CHECK_EQUAL(Mixed::TYPE_DOUBLE, doc.root().type());
+	BOOST_CHECK_CLOSE(doc.root().doubleValue(), -0.05, 0.000001);
+
+	doc.parse("N;");
+	BOOST_CHECK(!doc.empty());
+	BOOST_CHECK(doc.root().isNull());
+
+	BOOST_CHECK_THROW(doc.root().intValue(), std::runtime_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(Document_arrays) {
+
+	Document doc;
+
+	// Map
+	doc.parse("a:2:{s:2:\"ab\";s:2:\"cd\";i:5;a:1:{i:0;i:42;}}");
+
+	const DocumentValue &root = doc.root();
+
+	BOOST_CHECK_EQUAL(Mixed::TYPE_ARRAY, root.type());
+	BOOST_CHECK_EQUAL(MixedArray::TYPE_MAP, root.arrayType());
+	BOOST_CHECK_EQUAL(2, root.size());
+	BOOST_CHECK_EQUAL("ab", root.key(0).stringValue());
+	BOOST_CHECK_EQUAL("cd", root.value(0).stringValue());
+	BOOST_CHECK_EQUAL("cd", root.find("ab")->stringValue());
+	BOOST_CHECK(root.find("xy") == NULL);
+
+	// Vector
+	const DocumentValue *vec = root.find(5);
+
+	BOOST_REQUIRE(vec != NULL);
+	BOOST_CHECK_EQUAL(MixedArray::TYPE_VECTOR, vec->arrayType());
+	BOOST_CHECK_EQUAL(1, vec->size());
+	BOOST_CHECK_EQUAL(42, vec->find(0)->intValue());
+	BOOST_CHECK(vec->find(1) == NULL);
+	BOOST_CHECK_THROW(vec->value(1), std::out_of_range);
+
+	// Object
+	doc.parse("O:8:\"stdClass\":1:{s:1:\"a\";i:1;}");
+
+	BOOST_CHECK_EQUAL(Mixed::TYPE_ARRAY, doc.root().type());
+	BOOST_CHECK_EQUAL(1, doc.root().find("a")->intValue());
+}
+
+
+BOOST_AUTO_TEST_CASE(Document_toMixed) {
+
+	const std::string data = "a:3:{i:0;s:1:\"a\";i:1;a:2:{i:0;b:1;i:1;N;}s:1:\"k\";d:0.5;}";
+
+	Document doc;
+	doc.parse(data);
+
+	BOOST_CHECK(doc.root().toMixed() == *unserialize(data));
+	BOOST_CHECK(doc.root().find(1)->toMixed() == unserialize(data)->arrayValue().mapValue().find(Mixed(1))->second);
+}
+
+
+BOOST_AUTO_TEST_CASE(Document_invalid) {
+
+	Document doc;
+
+	// Element count larger than the data allows
+	BOOST_CHECK_THROW(doc.parse("a:1000000:{}"), std::runtime_error);
+
+	// Element count does not match
+	BOOST_CHECK_THROW(doc.parse("a:2:{i:0;i:1;}"), std::runtime_error);
+	BOOST_CHECK(doc.empty());
+
+	// Trailing data
+	BOOST_CHECK_THROW(doc.parse("i:1;i:2;"), std::runtime_error);
+	BOOST_CHECK_THROW(doc.parse(std::string("i:1;\0", 5)), std::runtime_error);
+
+	// An embedded NUL character is not the end of data
+	BOOST_CHECK_THROW(doc.parse(std::string("\0i:1;", 5)), std::runtime_error);
+}
@@ -0,0 +1,179 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#define BOOST_TEST_MODULE pherialize_KeyDictionary test
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "pherialize/KeyDictionary.hpp"
+#include "pherialize/unserialize.hpp"
+#include "pherialize/serialize.hpp"
+
+#include <string>
+#include <vector>
+#include <thread>
+
+#include <boost/lexical_cast.hpp>
+
+
+using namespace pherialize;
+
+
+BOOST_AUTO_TEST_CASE(internShares) {
+
+	KeyDictionary dict;
+
+	const Mixed a = dict.intern("user_id");
+	const Mixed b = dict.intern(std::string("user_id"));
+	const Mixed c = dict.intern("login");
+
+	BOOST_CHECK_EQUAL(Mixed::TYPE_STRING, a.type());
+	BOOST_CHECK_EQUAL("user_id", a.stringValue());
+	BOOST_CHECK_EQUAL(&a.stringValue(), &b.stringValue());
+	BOOST_CHECK_EQUAL(2, dict.size());
+
+	BOOST_CHECK(a == b);
+	BOOST_CHECK(!(a == c));
+	BOOST_CHECK(!(a < b) && !(b < a));
+	BOOST_CHECK(c < a);
+
+	// Interned and regular strings compare by value
+	BOOST_CHECK(a == Mixed("user_id"));
+	BOOST_CHECK(Mixed("user_id") == a);
+	BOOST_CHECK(!(a < Mixed("user_id")));
+
+	// Copies and moves share the string
+	Mixed copy(a);
+	Mixed moved(std::move(copy));
+
+	BOOST_CHECK_EQUAL(&a.stringValue(), &moved.stringValue());
+
+	copy = moved;
+	BOOST_CHECK_EQUAL(&a.stringValue(), &copy.stringValue());
+}
+
+
+BOOST_AUTO_TEST_CASE(internLimits) {
+
+	KeyDictionary dict(2, 4);
+
+	const Mixed longKey = dict.intern("abcde");
+	BOOST_CHECK_EQUAL("abcde", longKey.stringValue());
+	BOOST_CHECK_EQUAL(0, dict.size());
+
+	const Mixed a = dict.intern("a");
+	const Mixed b = dict.intern("b");
+	const Mixed c = dict.intern("c");
+	const Mixed c2 = dict.intern("c");
+
+	BOOST_CHECK_EQUAL(2, dict.size());
+	BOOST_CHECK_EQUAL("c", c.stringValue());
+	BOOST_CHECK(&c.stringValue() != &c2.stringValue());
+	BOOST_CHECK(c == c2);
+
+	BOOST_CHECK_EQUAL(&a.stringValue(), &dict.intern("a").stringValue());
+	BOOST_CHECK_EQUAL("", dict.intern("").stringValue());
+}
+
+
+BOOST_AUTO_TEST_CASE(internLifetime) {
+
+	Mixed a, b;
+
+	{
+		KeyDictionary dict1;
+		KeyDictionary dict2;
+
+		a = dict1.intern("key");
+		b = dict2.intern("key");
+	}
+
+	// Values outlive their dictionaries; strings of different
+	// dictionaries compare by value
+	BOOST_CHECK_EQUAL("key", a.stringValue());
+	BOOST_CHECK(a == b);
+	BOOST_CHECK(!(a < b));
+}
+
+
+BOOST_AUTO_TEST_CASE(internUnserialize) {
+
+	KeyDictionary dict;
+
+	const std::string data =
+		"a:3:{s:7:\"user_id\";i:1;s:5:\"roles\";a:1:{s:7:\"user_id\";s:7:\"user_id\";}i:5;b:1;}";
+
+	Unserializer un1(data);
+	un1.setKeyDictionary(&dict);
+	const shared_ptr <Mixed> m1 = un1.unserializeObject();
+
+	Unserializer un2(data);
+	un2.setKeyDictionary(&dict);
+	const shared_ptr <Mixed> m2 = un2.unserializeObject();
+
+	BOOST_CHECK_EQUAL(2, dict.size());
+
+	const std::vector <MixedArray::Entry> &e1 = m1->arrayValue().entries();
+	const std::vector <MixedArray::Entry> &e2 = m2->arrayValue().entries();
+
+	BOOST_CHECK_EQUAL(&e1[0].first.stringValue(), &e2[0].first.stringValue());
+
+	// Values are not interned
+	const MixedArray &roles = m1->arrayValue().find("roles")->arrayValue();
+
+	BOOST_CHECK_EQUAL(&e1[0].first.stringValue(), &roles.entries()[0].first.stringValue());
+	BOOST_CHECK(&e1[0].first.stringValue() != &roles.entries()[0].second.stringValue());
+
+	// Same value as without a dictionary
+	BOOST_CHECK(*m1 == *unserialize(data));
+	BOOST_CHECK_EQUAL(data, serialize(*m1));
+	BOOST_CHECK_EQUAL(1, m1->arrayValue().find("user_id")->intValue());
+	BOOST_CHECK_EQUAL(1, m1->arrayValue().mapValue().at(Mixed("user_id")).intValue());
+}
+
+
+BOOST_AUTO_TEST_CASE(internThreads) {
+
+	KeyDictionary dict;
+
+	std::vector <std::vector <Mixed> > results(4);
+	std::vector <std::thread> threads;
+
+	for (std::size_t t = 0 ; t < results.size() ; ++t) {
+
+		threads.push_back(std::thread([&dict, &results, t]() {
+
+			for (int i = 0 ; i < 2000 ; ++i) {
+				results[t].push_back(dict.intern("key" + boost::lexical_cast <std::string>(i % 500)));
+			}
+		}));
+	}
+
+	for (std::size_t t = 0 ; t < threads.size() ; ++t) {
+		threads[t].join();
+	}
+
+	BOOST_CHECK_EQUAL(500, dict.size());
+
+	for (std::size_t t = 1 ; t < results.size() ; ++t) {
+
+		for (int i = 0 ; i < 2000 ; ++i) {
+			BOOST_REQUIRE_EQUAL(&results[0][i].stringValue(), &results[t][i].stringValue());
+		}
+	}
+}
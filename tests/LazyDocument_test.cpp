@@ -0,0 +1,127 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#define BOOST_TEST_MODULE pherialize_LazyDocument test
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "pherialize/LazyDocument.hpp"
+#include "pherialize/unserialize.hpp"
+
+
+using namespace pherialize;
+
+
+BOOST_AUTO_TEST_CASE(LazyDocument_empty) {
+
+	const std::string data = "";
+	LazyDocument doc(data);
+
+	BOOST_CHECK(doc.empty());
+	BOOST_CHECK(doc.root().isNull());
+	BOOST_CHECK(doc.root().toMixed().isNull());
+}
+
+
+BOOST_AUTO_TEST_CASE(LazyDocument_scalars) {
+
+	const std::string str = "s:11:\"test string\";";
+	LazyDocument doc1(str);
+	BOOST_CHECK_EQUAL(Mixed::TYPE_STRING, doc1.root().type());
+	BOOST_CHECK_EQUAL("test string", doc1.root().stringValue());
+	BOOST_CHECK(doc1.root().stringData() == str.data() + 6);
+
+	const std::string data2 = "i:4242;";
+	LazyDocument doc2(data2);
+	BOOST_CHECK_EQUAL(Mixed::TYPE_INT, doc2.root().type());
+	BOOST_CHECK_EQUAL(4242, doc2.root().intValue());
+	BOOST_CHECK_THROW(doc2.root().boolValue(), std::runtime_error);
+
+	const std::string data3 = "b:1;";
+	LazyDocument doc3(data3);
+	BOOST_CHECK_EQUAL(true, doc3.root().boolValue());
+
+	const std::string data4 = "d:0.5;";
+	LazyDocument doc4(data4);
+	BOOST_CHECK_CLOSE(doc4.root().doubleValue(), 0.5, 0.000001);
+
+	const std::string data5 = "N;";
+	LazyDocument doc5(data5);
+	BOOST_CHECK(!doc5.empty());
+	BOOST_CHECK(doc5.root().isNull());
+}
+
+
+BOOST_AUTO_TEST_CASE(LazyDocument_arrays) {
+
+	const std::string data =
+		"a:3:{s:4:\"user\";a:2:{s:2:\"id\";i:42;s:5:\"prefs\";a:1:{s:4:\"lang\";s:5:\"en_US\";}}"
+		"s:5:\"items\";a:2:{i:0;s:1:\"a\";i:1;s:1:\"b\";}"
+		"s:4:\"blob\";s:10:\"0123456789\";}";
+
+	LazyDocument doc(data);
+
+	const LazyValue &root = doc.root();
+
+	BOOST_CHECK_EQUAL(Mixed::TYPE_ARRAY, root.type());
+	BOOST_CHECK_EQUAL(MixedArray::TYPE_MAP, root.arrayType());
+	BOOST_CHECK_EQUAL(3, root.size());
+	BOOST_CHECK_EQUAL("user", root.key(0).stringValue());
+
+	const LazyValue *lang = root.find("user")->find("prefs")->find("lang");
+
+	BOOST_REQUIRE(lang != NULL);
+	BOOST_CHECK_EQUAL("en_US", lang->stringValue());
+	BOOST_CHECK(root.find("user")->find("none") == NULL);
+
+	const LazyValue *items = root.find("items");
+
+	BOOST_CHECK_EQUAL(MixedArray::TYPE_VECTOR, items->arrayType());
+	BOOST_CHECK_EQUAL("b", items->find(1)->stringValue());
+	BOOST_CHECK(items->find(2) == NULL);
+
+	// Materialization
+	BOOST_CHECK(root.toMixed() == *unserialize(data));
+	BOOST_CHECK(items->toMixed() == *unserialize("a:2:{i:0;s:1:\"a\";i:1;s:1:\"b\";}"));
+}
+
+
+BOOST_AUTO_TEST_CASE(LazyDocument_invalid) {
+
+	// Unknown type
+	const std::string data1 = "x:1;";
+	BOOST_CHECK_THROW(LazyDocument doc1(data1), std::runtime_error);
+
+	// An embedded NUL character is not the end of data
+	const std::string nulData("\0i:1;", 5);
+	BOOST_CHECK_THROW(LazyDocument nulDoc(nulData), std::runtime_error);
+
+	// Errors are reported when the array is accessed
+	const std::string data2 = "a:2:{i:0;i:1;}";
+	LazyDocument doc2(data2);
+	BOOST_CHECK_THROW(doc2.root().size(), std::runtime_error);
+
+	const std::string data3 = "a:1:{i:0;s:5:\"ab\";}";
+	LazyDocument doc3(data3);
+	BOOST_CHECK_THROW(doc3.root().size(), std::runtime_error);
+
+	// Counts of skipped arrays are checked too
+	const std::string data4 = "a:1:{i:0;a:2:{i:0;i:1;}}";
+	LazyDocument doc4(data4);
+	BOOST_CHECK_THROW(doc4.root().size(), std::runtime_error);
+}
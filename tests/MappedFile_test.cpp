@@ -0,0 +1,123 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#define BOOST_TEST_MODULE pherialize_MappedFile test
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "pherialize/MappedFile.hpp"
+#include "pherialize/LazyDocument.hpp"
+#include "pherialize/unserialize.hpp"
+
+#include <boost/lexical_cast.hpp>
+
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+
+using namespace pherialize;
+
+
+// Creates a temporary file in the current directory, which is removed on destruction
+struct TempFile {
+
+	TempFile(const std::string &contents)
+		: path("pherialize-MappedFile-test-" + boost::lexical_cast <std::string>(counter++) + ".tmp") {
+
+		std::ofstream out(path.c_str(), std::ios::out | std::ios::binary);
+		out.write(contents.data(), contents.length());
+	}
+
+	~TempFile() {
+
+		std::remove(path.c_str());
+	}
+
+	const std::string path;
+
+	static int counter;
+};
+
+
+int TempFile::counter = 0;
+
+
+BOOST_AUTO_TEST_CASE(MappedFile_contents) {
+
+	const std::string contents = "a:1:{i:0;s:3:\"abc\";}";
+	TempFile file(contents);
+
+	MappedFile mf(file.path);
+
+	BOOST_CHECK_EQUAL(contents.length(), mf.length());
+	BOOST_CHECK(std::memcmp(contents.data(), mf.data(), contents.length()) == 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(MappedFile_empty) {
+
+	TempFile file("");
+
+	MappedFile mf(file.path);
+
+	BOOST_CHECK_EQUAL(0, mf.length());
+	BOOST_CHECK(!unserializeFile(file.path));
+}
+
+
+BOOST_AUTO_TEST_CASE(MappedFile_missing) {
+
+	BOOST_CHECK_THROW(MappedFile("/nonexistent/pherialize/file"), std::runtime_error);
+	BOOST_CHECK_THROW(unserializeFile("/nonexistent/pherialize/file"), std::runtime_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(MappedFile_unserializeFile) {
+
+	const std::string contents = "a:2:{s:3:\"foo\";i:42;s:3:\"bar\";a:1:{i:0;b:1;}}";
+	TempFile file(contents);
+
+	shared_ptr <Mixed> val = unserializeFile(file.path);
+
+	BOOST_REQUIRE(val);
+	BOOST_CHECK(*val == *unserialize(contents));
+
+	TempFile invalid(contents + "i:1;");
+	BOOST_CHECK_THROW(unserializeFile(invalid.path), std::runtime_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(MappedFile_lazyDocument) {
+
+	TempFile file("a:2:{s:3:\"foo\";s:5:\"hello\";s:3:\"bar\";i:7;}");
+
+	shared_ptr <MappedFile> mf(new MappedFile(file.path, MappedFile::ACCESS_RANDOM));
+	LazyDocument doc(mf);
+
+	// The document keeps the mapping alive
+	const char *data = mf->data();
+	mf.reset();
+
+	const LazyValue *foo = doc.root().find("foo");
+
+	BOOST_REQUIRE(foo);
+	BOOST_CHECK_EQUAL("hello", foo->stringValue());
+	BOOST_CHECK(foo->stringData() == data + 20);
+	BOOST_CHECK_EQUAL(7, doc.root().find("bar")->intValue());
+}
@@ -51,3 +51,150 @@ BOOST_AUTO_TEST_CASE(MixedArray_constructors) {
 	BOOST_CHECK(m2.type() == MixedArray::TYPE_MAP);
 	BOOST_CHECK(m2.mapValue() == m);
 }
+
+
+BOOST_AUTO_TEST_CASE(MixedArray_move) {
+
+	std::vector <Mixed> v;
+	v.push_back(Mixed(42));
+	v.push_back(Mixed("abc"));
+
+	// MixedArray(std::vector <Mixed> &&v)
+	std::vector <Mixed> v1(v);
+	MixedArray m1(std::move(v1));
+	BOOST_CHECK(m1.type() == MixedArray::TYPE_VECTOR);
+	BOOST_CHECK(m1.vectorValue() == v);
+
+	// MixedArray(MixedArray &&v)
+	MixedArray m2(std::move(m1));
+	BOOST_CHECK(m2.type() == MixedArray::TYPE_VECTOR);
+	BOOST_CHECK(m2.vectorValue() == v);
+	BOOST_CHECK(m1.type() == MixedArray::TYPE_NONE);
+
+	// MixedArray(std::map <Mixed, Mixed> &&v)
+	std::map <Mixed, Mixed> m;
+	m[Mixed("abc")] = Mixed("def");
+	std::map <Mixed, Mixed> mcopy(m);
+	MixedArray m3(std::move(mcopy));
+	BOOST_CHECK(m3.type() == MixedArray::TYPE_MAP);
+	BOOST_CHECK(m3.mapValue() == m);
+
+	// operator=(const MixedArray &v)
+	MixedArray m4;
+	m4 = m3;
+	BOOST_CHECK(m4 == m3);
+
+	// operator=(MixedArray &&v)
+	m4 = std::move(m2);
+	BOOST_CHECK(m4.type() == MixedArray::TYPE_VECTOR);
+	BOOST_CHECK(m4.vectorValue() == v);
+	BOOST_CHECK(m2.type() == MixedArray::TYPE_NONE);
+}
+
+
+BOOST_AUTO_TEST_CASE(MixedArray_find) {
+
+	std::map <Mixed, Mixed> map;
+	map[Mixed(42)] = Mixed("int key");
+	map[Mixed(true)] = Mixed("bool key");
+
+	for (int i = 0 ; i < 100 ; ++i) {
+		map[Mixed("key" + std::to_string(i))] = Mixed(i);
+	}
+
+	const MixedArray m(std::move(map));
+
+	for (int i = 0 ; i < 100 ; ++i) {
+
+		const Mixed *value = m.find("key" + std::to_string(i));
+
+		BOOST_REQUIRE(value != NULL);
+		BOOST_CHECK_EQUAL(i, value->intValue());
+	}
+
+	BOOST_CHECK(m.find("key100") == NULL);
+	BOOST_CHECK(m.find("") == NULL);
+	BOOST_CHECK_EQUAL(7, m.find("key7xyz", 4)->intValue());
+	BOOST_CHECK_EQUAL("int key", m.find(42)->stringValue());
+	BOOST_CHECK(m.find(43) == NULL);
+	BOOST_CHECK_EQUAL("bool key", m.find(Mixed(true))->stringValue());
+	BOOST_CHECK_EQUAL(3, m.find(Mixed("key3"))->intValue());
+
+	// The index refers to the copied entries
+	MixedArray copy(m);
+	const Mixed *value = copy.find("key5");
+
+	BOOST_REQUIRE(value != NULL);
+	BOOST_CHECK(value != m.find("key5"));
+	BOOST_CHECK_EQUAL(5, value->intValue());
+
+	// Vectors are looked up by index
+	std::vector <Mixed> vector;
+	vector.push_back(Mixed("a"));
+	vector.push_back(Mixed("b"));
+
+	const MixedArray v(vector);
+
+	BOOST_CHECK_EQUAL("b", v.find(1)->stringValue());
+	BOOST_CHECK(v.find(2) == NULL);
+	BOOST_CHECK(v.find(-1) == NULL);
+	BOOST_CHECK(v.find("0") == NULL);
+	BOOST_CHECK(MixedArray().find("a") == NULL);
+}
+
+
+BOOST_AUTO_TEST_CASE(MixedArray_entries) {
+
+	std::vector <MixedArray::Entry> entries;
+	entries.push_back(MixedArray::Entry(Mixed("zeta"), Mixed(1)));
+	entries.push_back(MixedArray::Entry(Mixed(7), Mixed(2)));
+	entries.push_back(MixedArray::Entry(Mixed("alpha"), Mixed(3)));
+	entries.push_back(MixedArray::Entry(Mixed("zeta"), Mixed(4)));  // duplicate
+
+	const MixedArray m(std::move(entries));
+
+	// Insertion order is kept, and the first duplicate wins
+	BOOST_REQUIRE_EQUAL(3, m.entries().size());
+	BOOST_CHECK(m.entries()[0].first == Mixed("zeta"));
+	BOOST_CHECK(m.entries()[1].first == Mixed(7));
+	BOOST_CHECK(m.entries()[2].first == Mixed("alpha"));
+	BOOST_CHECK_EQUAL(1, m.find("zeta")->intValue());
+	BOOST_CHECK_EQUAL(2, m.find(7)->intValue());
+
+	// Sorted view
+	const std::map <Mixed, Mixed> &map = m.mapValue();
+
+	BOOST_CHECK_EQUAL(3, map.size());
+	BOOST_CHECK(map.begin()->first == Mixed("alpha"));
+	BOOST_CHECK(&map == &m.mapValue());
+
+	// Order does not matter for equality
+	std::vector <MixedArray::Entry> reversed(m.entries().rbegin(), m.entries().rend());
+
+	BOOST_CHECK(MixedArray(reversed) == m);
+	BOOST_CHECK(MixedArray(map) == m);
+
+	reversed[0].second = Mixed(42);
+
+	BOOST_CHECK(MixedArray(reversed) != m);
+
+	BOOST_CHECK_THROW(MixedArray().entries(), std::runtime_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(MixedArray_convertToEntries) {
+
+	std::vector <Mixed> vector;
+	vector.reserve(4);
+	vector.push_back(Mixed("a"));
+	vector.push_back(Mixed("b"));
+
+	std::vector <MixedArray::Entry> entries;
+	MixedArray::convertToEntries(vector, entries);
+
+	BOOST_CHECK(vector.empty());
+	BOOST_CHECK(entries.capacity() >= 4);
+	BOOST_REQUIRE_EQUAL(2, entries.size());
+	BOOST_CHECK(entries[1].first == Mixed(1));
+	BOOST_CHECK(entries[1].second == Mixed("b"));
+}
@@ -149,3 +149,80 @@ BOOST_AUTO_TEST_CASE(Mixed_operator_neq) {
 	Mixed m4_2(42.42);
 	BOOST_CHECK(m4_1 != m4_2);
 }
+
+
+BOOST_AUTO_TEST_CASE(Mixed_move) {
+
+	// Mixed(std::string &&v)
+	std::string str("test string");
+	Mixed m0(std::move(str));
+	BOOST_CHECK(m0.type() == Mixed::TYPE_STRING);
+	BOOST_CHECK(m0.stringValue() == "test string");
+
+	// Mixed(Mixed &&v)
+	Mixed m1(std::move(m0));
+	BOOST_CHECK(m1.type() == Mixed::TYPE_STRING);
+	BOOST_CHECK(m1.stringValue() == "test string");
+	BOOST_CHECK(m0.isNull());
+
+	// Mixed(MixedArray &&v)
+	std::vector <Mixed> arr;
+	arr.push_back(Mixed(42));
+	MixedArray marr(arr);
+	Mixed m2(std::move(marr));
+	BOOST_CHECK(m2.type() == Mixed::TYPE_ARRAY);
+	BOOST_CHECK(m2.arrayValue() == arr);
+	BOOST_CHECK(marr.type() == MixedArray::TYPE_NONE);
+
+	// operator=(Mixed &&v)
+	Mixed m3(42);
+	m3 = std::move(m2);
+	BOOST_CHECK(m3.type() == Mixed::TYPE_ARRAY);
+	BOOST_CHECK(m3.arrayValue() == arr);
+	BOOST_CHECK(m2.isNull());
+
+	m3 = std::move(m3);
+	BOOST_CHECK(m3.type() == Mixed::TYPE_ARRAY);
+}
+
+
+BOOST_AUTO_TEST_CASE(Mixed_string_storage) {
+
+	const std::string shortStr("uid");
+	const std::string longStr(1000, 'x');
+
+	// Copy and assignment of short and long strings
+	Mixed m0(shortStr);
+	Mixed m1(longStr);
+
+	Mixed m2(m0);
+	Mixed m3(m1);
+	BOOST_CHECK(m2.stringValue() == shortStr);
+	BOOST_CHECK(m3.stringValue() == longStr);
+
+	m2 = m1;
+	m3 = Mixed(42);
+	BOOST_CHECK(m2.stringValue() == longStr);
+	BOOST_CHECK(m3.intValue() == 42);
+
+	m3 = std::move(m2);
+	BOOST_CHECK(m3.stringValue() == longStr);
+	BOOST_CHECK(m2.isNull());
+
+	// Ordering
+	BOOST_CHECK((m0 < m1) == (shortStr < longStr));
+	BOOST_CHECK(!(m0 < m0));
+}
+
+
+BOOST_AUTO_TEST_CASE(Mixed_int64) {
+
+	const Mixed m1(static_cast <std::int64_t>(1) << 40);
+
+	BOOST_CHECK_EQUAL(Mixed::TYPE_INT, m1.type());
+	BOOST_CHECK_EQUAL(1099511627776LL, m1.intValue());
+
+	BOOST_CHECK(Mixed(42) == Mixed(42L));
+	BOOST_CHECK(Mixed(42L) == Mixed(42LL));
+	BOOST_CHECK(Mixed(INT64_MIN) < Mixed(0));
+}
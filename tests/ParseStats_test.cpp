@@ -0,0 +1,210 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#define BOOST_TEST_MODULE pherialize_ParseStats test
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "pherialize/unserialize.hpp"
+#include "pherialize/MixedBuilder.hpp"
+#include "pherialize/ParseStats.hpp"
+#include "pherialize/KeyDictionary.hpp"
+
+#include <string>
+
+
+using namespace pherialize;
+
+
+// When statistics are compiled out, nothing is ever recorded
+#ifdef PHERIALIZE_DISABLE_STATS
+
+static void checkNothingRecorded(const ParseStats &stats) {
+
+	BOOST_CHECK_EQUAL(0, stats.bytes);
+	BOOST_CHECK_EQUAL(0, stats.totalNodes());
+	BOOST_CHECK_EQUAL(0, stats.maxDepth);
+	BOOST_CHECK_EQUAL(0, stats.allocations);
+	BOOST_CHECK_EQUAL(0, stats.allocatedBytes);
+}
+
+#endif // PHERIALIZE_DISABLE_STATS
+
+
+BOOST_AUTO_TEST_CASE(statsDisabledByDefault) {
+
+	ParseStats stats;
+
+	BOOST_CHECK_EQUAL(0, stats.totalNodes());
+	BOOST_CHECK_EQUAL(0, stats.bytes);
+
+	const std::string data = "a:1:{i:0;i:1;}";
+
+	Unserializer un(data);
+	un.unserializeObject();
+
+	BOOST_CHECK_EQUAL(0, stats.totalNodes());
+}
+
+
+BOOST_AUTO_TEST_CASE(statsNodes) {
+
+	const std::string data =
+		"a:3:{s:1:\"a\";i:1;s:1:\"b\";a:2:{i:0;d:0.5;i:1;N;}"
+		"s:1:\"c\";O:8:\"stdClass\":1:{s:1:\"x\";b:1;}}";
+
+	ParseStats stats;
+
+	Unserializer un(data);
+	un.setStats(&stats);
+	un.unserializeObject();
+
+#ifdef PHERIALIZE_DISABLE_STATS
+
+	checkNothingRecorded(stats);
+
+#else
+
+	BOOST_CHECK_EQUAL(data.length(), stats.bytes);
+	BOOST_CHECK_EQUAL(4, stats.nodes[Mixed::TYPE_STRING]);
+	BOOST_CHECK_EQUAL(3, stats.nodes[Mixed::TYPE_INT]);
+	BOOST_CHECK_EQUAL(1, stats.nodes[Mixed::TYPE_DOUBLE]);
+	BOOST_CHECK_EQUAL(1, stats.nodes[Mixed::TYPE_BOOL]);
+	BOOST_CHECK_EQUAL(1, stats.nodes[Mixed::TYPE_NULL]);
+	BOOST_CHECK_EQUAL(3, stats.nodes[Mixed::TYPE_ARRAY]);
+	BOOST_CHECK_EQUAL(13, stats.totalNodes());
+	BOOST_CHECK_EQUAL(2, stats.maxDepth);
+	BOOST_CHECK(stats.parseSeconds >= stats.indexSeconds);
+	BOOST_CHECK(stats.indexSeconds >= 0);
+
+	// Counters accumulate until reset
+	const std::string data2 = "i:42;";
+
+	Unserializer un2(data2);
+	un2.setStats(&stats);
+	un2.unserializeObject();
+
+	BOOST_CHECK_EQUAL(data.length() + 5, stats.bytes);
+	BOOST_CHECK_EQUAL(4, stats.nodes[Mixed::TYPE_INT]);
+	BOOST_CHECK_EQUAL(2, stats.maxDepth);
+
+	stats.reset();
+
+	BOOST_CHECK_EQUAL(0, stats.bytes);
+	BOOST_CHECK_EQUAL(0, stats.totalNodes());
+	BOOST_CHECK_EQUAL(0, stats.maxDepth);
+	BOOST_CHECK_EQUAL(0, stats.parseSeconds);
+
+#endif // PHERIALIZE_DISABLE_STATS
+}
+
+
+BOOST_AUTO_TEST_CASE(statsAllocations) {
+
+	const std::string longString(100, 'x');
+	const std::string data = "a:2:{i:0;s:1:\"a\";i:1;s:100:\"" + longString + "\";}";
+
+	ParseStats stats;
+
+	Unserializer un(data);
+	un.setStats(&stats);
+	un.unserializeObject();
+
+#ifdef PHERIALIZE_DISABLE_STATS
+
+	checkNothingRecorded(stats);
+
+#else
+
+	// Element buffer and long string
+	BOOST_CHECK_EQUAL(2, stats.allocations);
+	BOOST_CHECK_EQUAL(2 * sizeof(Mixed) + 101, stats.allocatedBytes);
+
+#endif // PHERIALIZE_DISABLE_STATS
+
+	un.setStats(NULL);
+}
+
+
+BOOST_AUTO_TEST_CASE(statsInternedKeys) {
+
+	const std::string longKey(20, 'k');
+	const std::string data = "a:2:{s:3:\"abc\";N;s:20:\"" + longKey + "\";N;}";
+
+	KeyDictionary dictionary;
+	ParseStats stats;
+
+	Unserializer un(data);
+	un.setKeyDictionary(&dictionary);
+	un.setStats(&stats);
+	un.unserializeObject();
+
+#ifdef PHERIALIZE_DISABLE_STATS
+
+	checkNothingRecorded(stats);
+
+#else
+
+	// Element buffer, map entries, then a new interned string for
+	// each key, and the characters of the long one
+	const std::size_t elements = 2 * sizeof(Mixed) + 2 * sizeof(MixedArray::Entry);
+
+	BOOST_CHECK_EQUAL(5, stats.allocations);
+	BOOST_CHECK_EQUAL(elements + 2 * sizeof(InternedString) + 21, stats.allocatedBytes);
+
+	// Keys which are in the dictionary are not allocated again
+	stats.reset();
+
+	Unserializer un2(data);
+	un2.setKeyDictionary(&dictionary);
+	un2.setStats(&stats);
+	un2.unserializeObject();
+
+	BOOST_CHECK_EQUAL(2, stats.allocations);
+	BOOST_CHECK_EQUAL(elements, stats.allocatedBytes);
+
+#endif // PHERIALIZE_DISABLE_STATS
+}
+
+
+BOOST_AUTO_TEST_CASE(statsHandler) {
+
+	ParseStats stats;
+	MixedBuilder builder;
+
+	const std::string data = "a:1:{i:0;a:1:{i:0;a:0:{}}}";
+
+	Unserializer un(data);
+	un.setStats(&stats);
+
+	BOOST_CHECK(un.unserializeObject(builder));
+
+#ifdef PHERIALIZE_DISABLE_STATS
+
+	checkNothingRecorded(stats);
+
+#else
+
+	BOOST_CHECK_EQUAL(26, stats.bytes);
+	BOOST_CHECK_EQUAL(3, stats.nodes[Mixed::TYPE_ARRAY]);
+	BOOST_CHECK_EQUAL(2, stats.nodes[Mixed::TYPE_INT]);
+	BOOST_CHECK_EQUAL(3, stats.maxDepth);
+	BOOST_CHECK_EQUAL(0, stats.allocations);
+
+#endif // PHERIALIZE_DISABLE_STATS
+}
@@ -0,0 +1,161 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#define BOOST_TEST_MODULE pherialize_StreamUnserializer test
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "pherialize/StreamUnserializer.hpp"
+#include "pherialize/unserialize.hpp"
+
+
+using namespace pherialize;
+
+
+static const std::string DATA =
+	"a:4:{i:0;s:11:\"test string\";i:1;a:2:{s:2:\"ab\";d:-0.05;s:0:\"\";N;}"
+	"s:1:\"k\";O:8:\"stdClass\":1:{s:1:\"a\";b:1;}i:7;i:-4242;}";
+
+
+BOOST_AUTO_TEST_CASE(StreamUnserializer_wholeData) {
+
+	StreamUnserializer un;
+
+	un.feed(DATA);
+
+	BOOST_CHECK(un.isComplete());
+
+	shared_ptr <Mixed> m = un.nextObject();
+
+	BOOST_REQUIRE(m != NULL);
+	BOOST_CHECK(*m == *unserialize(DATA));
+	BOOST_CHECK(un.nextObject() == NULL);
+}
+
+
+BOOST_AUTO_TEST_CASE(StreamUnserializer_splitData) {
+
+	const shared_ptr <Mixed> expected = unserialize(DATA);
+
+	// Split data at every possible position
+	for (std::size_t i = 0 ; i <= DATA.length() ; ++i) {
+
+		StreamUnserializer un;
+
+		un.feed(DATA.data(), i);
+
+		if (i > 0 && i < DATA.length()) {
+			BOOST_CHECK(!un.isComplete());
+			BOOST_CHECK(un.nextObject() == NULL);
+		}
+
+		un.feed(DATA.data() + i, DATA.length() - i);
+		un.finish();
+
+		shared_ptr <Mixed> m = un.nextObject();
+
+		BOOST_REQUIRE(m != NULL);
+		BOOST_CHECK(*m == *expected);
+	}
+
+	// One character at a time
+	StreamUnserializer un;
+
+	for (std::size_t i = 0 ; i < DATA.length() ; ++i) {
+		un.feed(DATA.data() + i, 1);
+	}
+
+	BOOST_CHECK(*un.nextObject() == *expected);
+}
+
+
+BOOST_AUTO_TEST_CASE(StreamUnserializer_multipleValues) {
+
+	StreamUnserializer un;
+
+	un.feed("i:1;s:3:\"a");
+	BOOST_CHECK_EQUAL(1, un.nextObject()->intValue());
+	BOOST_CHECK(un.nextObject() == NULL);
+
+	un.feed("bc\";N;i:");
+	BOOST_CHECK_EQUAL("abc", un.nextObject()->stringValue());
+	BOOST_CHECK(un.nextObject()->isNull());
+	BOOST_CHECK(!un.isComplete());
+
+	BOOST_CHECK_THROW(un.finish(), std::runtime_error);
+
+	un.feed("2;");
+	BOOST_CHECK_EQUAL(2, un.nextObject()->intValue());
+
+	un.finish();
+}
+
+
+class CountHandler : public UnserializeHandler {
+
+public:
+
+	CountHandler() : strings(0), arrays(0) { }
+
+	void onString(const char * /* str */, const std::size_t /* length */) { ++strings; }
+	void onArrayEnd() { ++arrays; }
+
+	int strings;
+	int arrays;
+};
+
+
+BOOST_AUTO_TEST_CASE(StreamUnserializer_handler) {
+
+	CountHandler handler;
+	StreamUnserializer un(handler);
+
+	un.feed(DATA.substr(0, 20));
+	un.feed(DATA.substr(20));
+
+	BOOST_CHECK_EQUAL(5, handler.strings);
+	BOOST_CHECK_EQUAL(3, handler.arrays);
+	BOOST_CHECK(un.nextObject() == NULL);
+}
+
+
+BOOST_AUTO_TEST_CASE(StreamUnserializer_invalid) {
+
+	StreamUnserializer un1;
+	BOOST_CHECK_THROW(un1.feed("x:1;"), std::runtime_error);
+
+	// Cannot be used after an error
+	BOOST_CHECK_THROW(un1.feed("i:1;"), std::runtime_error);
+
+	StreamUnserializer un2;
+	un2.feed("s:3:\"ab");
+	BOOST_CHECK_THROW(un2.feed("cd\";"), std::runtime_error);
+
+	StreamUnserializer un3;
+	BOOST_CHECK_THROW(un3.feed("i:12345678901234567890123456789012345678901234567890"
+		"12345678901234567890123456789012345678901234567890123456789012345678901234567890"), std::runtime_error);
+
+	// Element count mismatch
+	StreamUnserializer un4;
+	un4.feed("a:2:{i:0;i:1;");
+	BOOST_CHECK_THROW(un4.feed("}"), std::runtime_error);
+
+	StreamUnserializer un5;
+	un5.feed("a:1:{i:0;i:1;");
+	BOOST_CHECK_THROW(un5.feed("i:1;"), std::runtime_error);
+}
@@ -0,0 +1,174 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#define BOOST_TEST_MODULE pherialize_serializeFrom test
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "pherialize/serializeFrom.hpp"
+#include "pherialize/unserializeAs.hpp"
+#include "pherialize/unserialize.hpp"
+#include "pherialize/serialize.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <boost/optional.hpp>
+
+
+using namespace pherialize;
+
+
+struct Item {
+	std::string name;
+	double price;
+};
+
+
+struct Cart {
+	unsigned int id;
+	bool paid;
+	std::vector <Item> items;
+	std::map <std::string, int> quantities;
+	boost::optional <std::string> coupon;
+	boost::optional <Item> gift;
+};
+
+
+namespace pherialize {
+
+
+template <>
+struct Descriptor <Item> {
+
+	template <typename Visitor>
+	static void describe(Visitor &v) {
+
+		v.field("name", &Item::name);
+		v.field("price", &Item::price);
+	}
+};
+
+
+template <>
+struct Descriptor <Cart> {
+
+	template <typename Visitor>
+	static void describe(Visitor &v) {
+
+		v.field("id", &Cart::id);
+		v.field("paid", &Cart::paid);
+		v.field("items", &Cart::items);
+		v.field("quantities", &Cart::quantities);
+		v.field("coupon", &Cart::coupon);
+		v.field("gift", &Cart::gift);
+	}
+};
+
+
+} // namespace pherialize
+
+
+static Cart makeCart() {
+
+	Cart cart;
+	cart.id = 42;
+	cart.paid = false;
+
+	Item item;
+	item.name = "book";
+	item.price = 12.5;
+	cart.items.push_back(item);
+
+	item.name = "pen";
+	item.price = 0.1;
+	cart.items.push_back(item);
+
+	cart.quantities["book"] = 1;
+	cart.quantities["pen"] = 3;
+
+	cart.gift = item;
+
+	return cart;
+}
+
+
+BOOST_AUTO_TEST_CASE(serializeFromStruct) {
+
+	BOOST_CHECK_EQUAL(
+		"a:6:{s:2:\"id\";i:42;s:4:\"paid\";b:0;"
+		"s:5:\"items\";a:2:{i:0;a:2:{s:4:\"name\";s:4:\"book\";s:5:\"price\";d:12.5;}"
+		"i:1;a:2:{s:4:\"name\";s:3:\"pen\";s:5:\"price\";d:0.1;}}"
+		"s:10:\"quantities\";a:2:{s:4:\"book\";i:1;s:3:\"pen\";i:3;}"
+		"s:6:\"coupon\";N;"
+		"s:4:\"gift\";a:2:{s:4:\"name\";s:3:\"pen\";s:5:\"price\";d:0.1;}}",
+		serializeFrom(makeCart())
+	);
+}
+
+
+BOOST_AUTO_TEST_CASE(serializeFromRoundTrip) {
+
+	Cart cart = makeCart();
+	cart.coupon = std::string("SALE\"10;");
+
+	const std::string data = serializeFrom(cart);
+
+	// Same output as the generic serializer
+	BOOST_CHECK_EQUAL(serialize(*unserialize(data)), data);
+
+	const Cart copy = unserializeAs <Cart>(data);
+
+	BOOST_CHECK_EQUAL(42, copy.id);
+	BOOST_REQUIRE_EQUAL(2, copy.items.size());
+	BOOST_CHECK_EQUAL(0.1, copy.items[1].price);
+	BOOST_CHECK_EQUAL(3, copy.quantities.at("pen"));
+	BOOST_CHECK_EQUAL("SALE\"10;", *copy.coupon);
+	BOOST_CHECK_EQUAL("pen", copy.gift->name);
+}
+
+
+BOOST_AUTO_TEST_CASE(serializeFromScalars) {
+
+	BOOST_CHECK_EQUAL("i:-9223372036854775808;", serializeFrom(INT64_MIN));
+	BOOST_CHECK_EQUAL("i:0;", serializeFrom(0));
+	BOOST_CHECK_EQUAL("b:1;", serializeFrom(true));
+	BOOST_CHECK_EQUAL("d:1.0E+25;", serializeFrom(1e25));
+	BOOST_CHECK_EQUAL("s:0:\"\";", serializeFrom(std::string()));
+	BOOST_CHECK_EQUAL("N;", serializeFrom(boost::optional <int>()));
+	BOOST_CHECK_EQUAL("a:2:{i:0;b:1;i:1;b:0;}", serializeFrom(std::vector <bool>{true, false}));
+	BOOST_CHECK_EQUAL("a:1:{i:-1;s:1:\"x\";}", serializeFrom(std::map <int, std::string>{{-1, "x"}}));
+
+	BOOST_CHECK_THROW(serializeFrom(UINT64_MAX), std::runtime_error);
+
+	// String keys which are the canonical form of an integer are
+	// written as integers, as in PHP
+	const std::map <std::string, int> keys{{"7", 1}, {"07", 2}, {"-3", 3}, {"a", 4}};
+
+	BOOST_CHECK_EQUAL(
+		"a:4:{i:-3;i:3;s:2:\"07\";i:2;i:7;i:1;s:1:\"a\";i:4;}",
+		serializeFrom(keys)
+	);
+
+	// Appending
+	std::string out = "x";
+	serializeFrom(1, out);
+
+	BOOST_CHECK_EQUAL("xi:1;", out);
+}
@@ -0,0 +1,258 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#define BOOST_TEST_MODULE pherialize_serialize test
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "pherialize/serialize.hpp"
+#include "pherialize/unserialize.hpp"
+
+#include <limits>
+#include <random>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+
+
+using namespace pherialize;
+
+
+BOOST_AUTO_TEST_CASE(serializeScalars) {
+
+	BOOST_CHECK_EQUAL("N;", serialize(Mixed()));
+	BOOST_CHECK_EQUAL("b:1;", serialize(Mixed(true)));
+	BOOST_CHECK_EQUAL("b:0;", serialize(Mixed(false)));
+	BOOST_CHECK_EQUAL("i:0;", serialize(Mixed(0)));
+	BOOST_CHECK_EQUAL("i:4242;", serialize(Mixed(4242)));
+	BOOST_CHECK_EQUAL("i:-7;", serialize(Mixed(-7)));
+	BOOST_CHECK_EQUAL("i:-2147483648;", serialize(Mixed(std::numeric_limits <int>::min())));
+	BOOST_CHECK_EQUAL("i:1700000000123;", serialize(Mixed(1700000000123LL)));
+	BOOST_CHECK_EQUAL("i:-9223372036854775808;", serialize(Mixed(INT64_MIN)));
+	BOOST_CHECK_EQUAL("s:0:\"\";", serialize(Mixed("")));
+	BOOST_CHECK_EQUAL("s:11:\"test string\";", serialize(Mixed("test string")));
+	BOOST_CHECK_EQUAL("s:4:\"a\"b;\";", serialize(Mixed("a\"b;")));
+}
+
+
+BOOST_AUTO_TEST_CASE(serializeDouble) {
+
+	BOOST_CHECK_EQUAL("d:0;", serialize(Mixed(0.0)));
+	BOOST_CHECK_EQUAL("d:-0;", serialize(Mixed(-0.0)));
+	BOOST_CHECK_EQUAL("d:1.5;", serialize(Mixed(1.5)));
+	BOOST_CHECK_EQUAL("d:-42.25;", serialize(Mixed(-42.25)));
+	BOOST_CHECK_EQUAL("d:100;", serialize(Mixed(100.0)));
+	BOOST_CHECK_EQUAL("d:0.1;", serialize(Mixed(0.1)));
+	BOOST_CHECK_EQUAL("d:0.30000000000000004;", serialize(Mixed(0.1 + 0.2)));
+	BOOST_CHECK_EQUAL("d:3.141592653589793;", serialize(Mixed(3.141592653589793)));
+	BOOST_CHECK_EQUAL("d:0.0001;", serialize(Mixed(0.0001)));
+	BOOST_CHECK_EQUAL("d:1.0E-5;", serialize(Mixed(0.00001)));
+	BOOST_CHECK_EQUAL("d:1.5E-7;", serialize(Mixed(1.5e-7)));
+	BOOST_CHECK_EQUAL("d:1.0E+25;", serialize(Mixed(1e25)));
+	BOOST_CHECK_EQUAL("d:9.223372036854776E+18;", serialize(Mixed(9223372036854775808.0)));
+	BOOST_CHECK_EQUAL("d:5.0E-324;", serialize(Mixed(std::numeric_limits <double>::denorm_min())));
+	BOOST_CHECK_EQUAL("d:1.7976931348623157E+308;", serialize(Mixed(std::numeric_limits <double>::max())));
+	BOOST_CHECK_EQUAL("d:INF;", serialize(Mixed(std::numeric_limits <double>::infinity())));
+	BOOST_CHECK_EQUAL("d:-INF;", serialize(Mixed(-std::numeric_limits <double>::infinity())));
+	BOOST_CHECK_EQUAL("d:NAN;", serialize(Mixed(std::numeric_limits <double>::quiet_NaN())));
+}
+
+
+BOOST_AUTO_TEST_CASE(serializeDoubleShortest) {
+
+	// Values with the same bits as random 64-bit integers, covering
+	// all exponents, and values with few significant bits
+	std::mt19937_64 random(42);
+
+	char buffer[MAX_DOUBLE_LENGTH + 1];
+	char shorter[MAX_DOUBLE_LENGTH];
+
+	for (int i = 0 ; i < 100000 ; ++i) {
+
+		std::uint64_t bits = random();
+
+		if (i % 2 == 1) {
+			bits &= 0xFFFFFFF000000000ULL;
+		}
+
+		double value;
+		std::memcpy(&value, &bits, sizeof(value));
+
+		if (!std::isfinite(value) || value == 0) {
+			continue;
+		}
+
+		const std::size_t length = formatDouble(value, buffer);
+		buffer[length] = '\0';
+
+		// Reads back to the same value...
+		BOOST_REQUIRE_MESSAGE(std::strtod(buffer, NULL) == value, buffer);
+
+		// ...and no shorter representation does
+		std::string digits;
+
+		for (const char *p = buffer ; *p != '\0' && *p != 'E' ; ++p) {
+			if (*p >= '0' && *p <= '9' && (!digits.empty() || *p != '0')) {
+				digits += *p;
+			}
+		}
+
+		while (digits.length() > 1 && digits[digits.length() - 1] == '0') {
+			digits.erase(digits.length() - 1);
+		}
+
+		if (digits.length() > 1) {
+
+			std::snprintf(shorter, sizeof(shorter), "%.*e", static_cast <int>(digits.length()) - 2, value);
+
+			BOOST_CHECK_MESSAGE(std::strtod(shorter, NULL) != value,
+				std::string(buffer) + " is not the shortest, " + shorter + " reads back");
+		}
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(serializeArray) {
+
+	BOOST_CHECK_EQUAL("a:0:{}", serialize(Mixed(MixedArray())));
+	BOOST_CHECK_EQUAL("a:0:{}", serialize(Mixed(MixedArray(std::vector <Mixed>()))));
+
+	std::vector <Mixed> vector;
+	vector.push_back(Mixed("foo"));
+	vector.push_back(Mixed(42));
+
+	BOOST_CHECK_EQUAL("a:2:{i:0;s:3:\"foo\";i:1;i:42;}", serialize(Mixed(MixedArray(vector))));
+
+	std::map <Mixed, Mixed> map;
+	map[Mixed("key")] = Mixed(MixedArray(vector));
+	map[Mixed(5)] = Mixed();
+
+	BOOST_CHECK_EQUAL(
+		"a:2:{s:3:\"key\";a:2:{i:0;s:3:\"foo\";i:1;i:42;}i:5;N;}",
+		serialize(Mixed(MixedArray(map)))
+	);
+}
+
+
+BOOST_AUTO_TEST_CASE(serializeKeyConversion) {
+
+	std::map <Mixed, Mixed> map;
+	map[Mixed(true)] = Mixed(1);
+	map[Mixed(2.7)] = Mixed(2);
+
+	BOOST_CHECK_EQUAL("a:2:{i:1;i:1;i:2;i:2;}", serialize(Mixed(MixedArray(map))));
+
+	// Double keys which do not fit in an integer are converted as PHP
+	// does: NAN and infinities give 0, other values wrap modulo 2^64
+	const double keys[] = {
+		std::numeric_limits <double>::quiet_NaN(),
+		std::numeric_limits <double>::infinity(),
+		-std::numeric_limits <double>::infinity(),
+		-2.5, 1e19, -1e19, 9223372036854775808.0, -9223372036854775808.0, 1e300
+	};
+
+	const char *expected[] = {
+		"i:0;", "i:0;", "i:0;",
+		"i:-2;", "i:-8446744073709551616;", "i:8446744073709551616;",
+		"i:-9223372036854775808;", "i:-9223372036854775808;", "i:0;"
+	};
+
+	for (std::size_t i = 0 ; i < sizeof(keys) / sizeof(keys[0]) ; ++i) {
+
+		std::vector <MixedArray::Entry> entries;
+		entries.emplace_back(Mixed(keys[i]), Mixed());
+
+		const std::string data = serialize(Mixed(MixedArray(entries)));
+
+		BOOST_CHECK_EQUAL(std::string("a:1:{") + expected[i] + "N;}", data);
+		BOOST_CHECK_EQUAL(data.length(), Serializer().computeSize(Mixed(MixedArray(entries))));
+	}
+
+	std::map <Mixed, Mixed> invalid;
+	invalid[Mixed(MixedArray())] = Mixed(1);
+
+	BOOST_CHECK_THROW(serialize(Mixed(MixedArray(invalid))), std::runtime_error);
+
+	// Strings which are the canonical form of an integer are written
+	// as integers, other strings are kept
+	std::vector <MixedArray::Entry> numeric;
+	numeric.emplace_back(Mixed("42"), Mixed(1));
+	numeric.emplace_back(Mixed("-7"), Mixed(2));
+	numeric.emplace_back(Mixed("-9223372036854775808"), Mixed(3));
+	numeric.emplace_back(Mixed("042"), Mixed(4));
+	numeric.emplace_back(Mixed("-0"), Mixed(5));
+	numeric.emplace_back(Mixed("+1"), Mixed(6));
+	numeric.emplace_back(Mixed("9223372036854775808"), Mixed(7));
+	numeric.emplace_back(Mixed("1.5"), Mixed(8));
+	numeric.emplace_back(Mixed(), Mixed(9));
+
+	const Mixed numericMap = Mixed(MixedArray(numeric));
+	const std::string numericData =
+		"a:9:{i:42;i:1;i:-7;i:2;i:-9223372036854775808;i:3;s:3:\"042\";i:4;s:2:\"-0\";i:5;"
+		"s:2:\"+1\";i:6;s:19:\"9223372036854775808\";i:7;s:3:\"1.5\";i:8;s:0:\"\";i:9;}";
+
+	BOOST_CHECK_EQUAL(numericData, serialize(numericMap));
+	BOOST_CHECK_EQUAL(numericData.length(), Serializer().computeSize(numericMap));
+
+	// Keys which are the same once converted cannot be written
+	std::vector <MixedArray::Entry> colliding;
+	colliding.emplace_back(Mixed("42"), Mixed(1));
+	colliding.emplace_back(Mixed(true), Mixed(2));
+	colliding.emplace_back(Mixed(1), Mixed(3));
+
+	BOOST_CHECK_THROW(serialize(Mixed(MixedArray(colliding))), std::runtime_error);
+
+	std::vector <MixedArray::Entry> collidingString;
+	collidingString.emplace_back(Mixed("42"), Mixed(1));
+	collidingString.emplace_back(Mixed(42), Mixed(2));
+
+	BOOST_CHECK_THROW(serialize(Mixed(MixedArray(collidingString))), std::runtime_error);
+
+	std::vector <MixedArray::Entry> collidingNull;
+	collidingNull.emplace_back(Mixed(""), Mixed(1));
+	collidingNull.emplace_back(Mixed(), Mixed(2));
+
+	BOOST_CHECK_THROW(Serializer().computeSize(Mixed(MixedArray(collidingNull))), std::runtime_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(serializeRoundTrip) {
+
+	const std::string data =
+		"a:3:{s:3:\"foo\";a:2:{i:0;d:0.5;i:1;b:0;}i:7;d:-0.25;s:0:\"\";N;}";
+
+	shared_ptr <Mixed> m = unserialize(data);
+
+	BOOST_CHECK_EQUAL(data.length(), Serializer().computeSize(*m));
+	BOOST_CHECK_EQUAL(data, serialize(*m));
+}
+
+
+BOOST_AUTO_TEST_CASE(serializeAppend) {
+
+	Serializer ser;
+	std::string out = "prefix:";
+
+	ser.serializeObject(Mixed(1.25), out);
+	ser.serializeObject(Mixed("x"), out);
+
+	BOOST_CHECK_EQUAL("prefix:d:1.25;s:1:\"x\";", out);
+}
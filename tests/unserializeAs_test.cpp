@@ -0,0 +1,341 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#define BOOST_TEST_MODULE pherialize_unserializeAs test
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "pherialize/unserializeAs.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <boost/optional.hpp>
+
+
+using namespace pherialize;
+
+
+struct Address {
+	std::string city;
+	int zip;
+};
+
+
+struct Node {
+	std::vector <Node> kids;
+	int id;
+};
+
+
+struct Point {
+	int x;
+	int y;
+};
+
+
+// Number of calls to Descriptor <Point>::describe(): the fast path
+// visits the fields once per struct, key matching once per key
+static int pointDescribeCalls = 0;
+
+
+struct Session {
+	long long userId;
+	std::string login;
+	bool loggedIn;
+	double cartTotal;
+	boost::optional <std::string> flash;
+	std::vector <std::string> roles;
+	std::map <std::string, int> counters;
+	Address address;
+	boost::optional <Address> billing;
+};
+
+
+namespace pherialize {
+
+
+template <>
+struct Descriptor <Address> {
+
+	template <typename Visitor>
+	static void describe(Visitor &v) {
+
+		v.field("city", &Address::city);
+		v.field("zip", &Address::zip);
+	}
+};
+
+
+template <>
+struct Descriptor <Node> {
+
+	template <typename Visitor>
+	static void describe(Visitor &v) {
+
+		v.field("kids", &Node::kids);
+		v.field("id", &Node::id);
+	}
+};
+
+
+template <>
+struct Descriptor <Point> {
+
+	template <typename Visitor>
+	static void describe(Visitor &v) {
+
+		++pointDescribeCalls;
+
+		v.field("x", &Point::x);
+		v.field("y", &Point::y);
+	}
+};
+
+
+template <>
+struct Descriptor <Session> {
+
+	template <typename Visitor>
+	static void describe(Visitor &v) {
+
+		v.field("user_id", &Session::userId);
+		v.field("login", &Session::login);
+		v.field("logged_in", &Session::loggedIn);
+		v.field("cart_total", &Session::cartTotal);
+		v.field("flash", &Session::flash);
+		v.field("roles", &Session::roles);
+		v.field("counters", &Session::counters);
+		v.field("address", &Session::address);
+		v.field("billing", &Session::billing);
+	}
+};
+
+
+} // namespace pherialize
+
+
+static const std::string sessionData =
+	"a:10:{"
+	"s:7:\"user_id\";i:1700000000123;"
+	"s:5:\"login\";s:4:\"jdoe\";"
+	"s:9:\"logged_in\";b:1;"
+	"s:10:\"cart_total\";d:12.5;"
+	"s:5:\"flash\";N;"
+	"s:5:\"roles\";a:2:{i:0;s:5:\"admin\";i:1;s:6:\"editor\";}"
+	"s:7:\"unknown\";a:1:{i:0;a:1:{s:4:\"deep\";d:1.5;}}"
+	"s:8:\"counters\";a:2:{s:6:\"visits\";i:3;i:42;i:7;}"
+	"s:7:\"address\";a:2:{s:4:\"city\";s:5:\"Paris\";s:3:\"zip\";i:75001;}"
+	"i:5;s:7:\"ignored\";"
+	"}";
+
+
+BOOST_AUTO_TEST_CASE(unserializeAsStruct) {
+
+	const Session s = unserializeAs <Session>(sessionData);
+
+	BOOST_CHECK_EQUAL(1700000000123LL, s.userId);
+	BOOST_CHECK_EQUAL("jdoe", s.login);
+	BOOST_CHECK_EQUAL(true, s.loggedIn);
+	BOOST_CHECK_EQUAL(12.5, s.cartTotal);
+	BOOST_CHECK(!s.flash);
+	BOOST_REQUIRE_EQUAL(2, s.roles.size());
+	BOOST_CHECK_EQUAL("admin", s.roles[0]);
+	BOOST_CHECK_EQUAL("editor", s.roles[1]);
+	BOOST_REQUIRE_EQUAL(2, s.counters.size());
+	BOOST_CHECK_EQUAL(3, s.counters.at("visits"));
+	BOOST_CHECK_EQUAL(7, s.counters.at("42"));
+	BOOST_CHECK_EQUAL("Paris", s.address.city);
+	BOOST_CHECK_EQUAL(75001, s.address.zip);
+	BOOST_CHECK(!s.billing);
+}
+
+
+BOOST_AUTO_TEST_CASE(unserializeAsObject) {
+
+	// Property names of protected and private properties are prefixed
+	const char raw[] =
+		"O:7:\"Address\":2:{s:7:\"\0*\0city\";s:4:\"Lyon\";s:12:\"\0Address\0zip\";i:69001;}";
+
+	const std::string data(raw, sizeof(raw) - 1);
+
+	const Address a = unserializeAs <Address>(data);
+
+	BOOST_CHECK_EQUAL("Lyon", a.city);
+	BOOST_CHECK_EQUAL(69001, a.zip);
+
+	boost::optional <Address> opt;
+	unserializeInto(data, opt);
+
+	BOOST_REQUIRE(opt);
+	BOOST_CHECK_EQUAL("Lyon", opt->city);
+}
+
+
+BOOST_AUTO_TEST_CASE(unserializeAsMissingFields) {
+
+	Address a;
+	a.city = "unchanged";
+	a.zip = 1;
+
+	unserializeInto("a:1:{s:3:\"zip\";i:2;}", a);
+
+	BOOST_CHECK_EQUAL("unchanged", a.city);
+	BOOST_CHECK_EQUAL(2, a.zip);
+}
+
+
+BOOST_AUTO_TEST_CASE(unserializeAsScalars) {
+
+	BOOST_CHECK_EQUAL(42, unserializeAs <int>("i:42;"));
+	BOOST_CHECK_EQUAL(2.0, unserializeAs <double>("i:2;"));
+	BOOST_CHECK_EQUAL("abc", unserializeAs <std::string>("s:3:\"abc\";"));
+	BOOST_CHECK_EQUAL(false, unserializeAs <bool>("b:0;"));
+	BOOST_CHECK_EQUAL(255, unserializeAs <unsigned char>("i:255;"));
+
+	const std::vector <int> v = unserializeAs <std::vector <int> >("a:3:{i:0;i:1;i:1;i:2;i:2;i:3;}");
+
+	BOOST_REQUIRE_EQUAL(3, v.size());
+	BOOST_CHECK_EQUAL(3, v[2]);
+
+	const std::map <int, std::vector <bool> > m =
+		unserializeAs <std::map <int, std::vector <bool> > >("a:2:{i:5;a:1:{i:0;b:1;}i:5;a:0:{}}");
+
+	BOOST_REQUIRE_EQUAL(1, m.size());
+	BOOST_CHECK_EQUAL(1, m.at(5).size());
+}
+
+
+BOOST_AUTO_TEST_CASE(unserializeAsErrors) {
+
+	BOOST_CHECK_THROW(unserializeAs <int>(""), std::runtime_error);
+	BOOST_CHECK_THROW(unserializeAs <int>("s:1:\"1\";"), std::runtime_error);
+	BOOST_CHECK_THROW(unserializeAs <int>("N;"), std::runtime_error);
+	BOOST_CHECK_THROW(unserializeAs <int>("i:1;i:2;"), std::runtime_error);
+	BOOST_CHECK_THROW(unserializeAs <int>(std::string("i:1;\0", 5)), std::runtime_error);
+	BOOST_CHECK_THROW(unserializeAs <int>(std::string("\0i:1;", 5)), std::runtime_error);
+	BOOST_CHECK_THROW(unserializeAs <unsigned char>("i:256;"), std::runtime_error);
+	BOOST_CHECK_THROW(unserializeAs <unsigned int>("i:-1;"), std::runtime_error);
+
+	typedef std::map <int, int> IntMap;
+
+	BOOST_CHECK_THROW(unserializeAs <IntMap>("a:1:{s:1:\"a\";i:1;}"), std::runtime_error);
+	BOOST_CHECK_THROW(unserializeAs <Address>("i:1;"), std::runtime_error);
+	BOOST_CHECK_THROW(unserializeAs <Address>("a:1:{s:3:\"zip\";s:1:\"1\";}"), std::runtime_error);
+	BOOST_CHECK_THROW(unserializeAs <Session>(sessionData.substr(0, 100)), std::runtime_error);
+
+	try {
+
+		unserializeAs <Address>("a:1:{s:4:\"city\";i:1;}");
+		BOOST_FAIL("Expected an exception");
+
+	} catch (std::runtime_error &e) {
+
+		BOOST_CHECK_EQUAL("Invalid value type for 'string'.", std::string(e.what()));
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(unserializeAsFixedShape) {
+
+	// Fields in the order of the descriptor
+	const Address a = unserializeAs <Address>("a:2:{s:4:\"city\";s:4:\"Nice\";s:3:\"zip\";i:6000;}");
+
+	BOOST_CHECK_EQUAL("Nice", a.city);
+	BOOST_CHECK_EQUAL(6000, a.zip);
+
+	// Other order, other count, other key after a matching one: these
+	// are decoded by matching keys
+	const Address b = unserializeAs <Address>("a:2:{s:3:\"zip\";i:6000;s:4:\"city\";s:4:\"Nice\";}");
+
+	BOOST_CHECK_EQUAL("Nice", b.city);
+	BOOST_CHECK_EQUAL(6000, b.zip);
+
+	const Address c = unserializeAs <Address>("a:3:{s:4:\"city\";s:4:\"Nice\";s:3:\"zip\";i:6000;s:1:\"x\";N;}");
+
+	BOOST_CHECK_EQUAL("Nice", c.city);
+	BOOST_CHECK_EQUAL(6000, c.zip);
+
+	const Address d = unserializeAs <Address>("a:2:{s:4:\"city\";s:4:\"Nice\";s:3:\"ZIP\";i:1;}");
+
+	BOOST_CHECK_EQUAL("Nice", d.city);
+	BOOST_CHECK_EQUAL(0, d.zip);
+
+	// Errors in values are reported as such
+	BOOST_CHECK_THROW(unserializeAs <Address>("a:2:{s:4:\"city\";i:1;s:3:\"zip\";i:6000;}"), std::runtime_error);
+	BOOST_CHECK_THROW(unserializeAs <Address>("a:2:{s:4:\"city\";s:4:\"Nice\";s:3:\"zip\";i:6000;"), std::runtime_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(unserializeAsFixedShapeTaken) {
+
+	const std::string fixed = "a:2:{s:1:\"x\";i:1;s:1:\"y\";i:2;}";
+	const std::string reordered = "a:2:{s:1:\"y\";i:2;s:1:\"x\";i:1;}";
+
+	// The fragments of the struct are built on first use
+	unserializeAs <Point>(fixed);
+
+	pointDescribeCalls = 0;
+
+	const Point p = unserializeAs <Point>(fixed);
+
+	BOOST_CHECK_EQUAL(1, p.x);
+	BOOST_CHECK_EQUAL(2, p.y);
+	BOOST_CHECK_EQUAL(1, pointDescribeCalls);
+
+	// Fast path, then one call per key
+	pointDescribeCalls = 0;
+
+	const Point q = unserializeAs <Point>(reordered);
+
+	BOOST_CHECK_EQUAL(1, q.x);
+	BOOST_CHECK_EQUAL(2, q.y);
+	BOOST_CHECK_EQUAL(3, pointDescribeCalls);
+}
+
+
+BOOST_AUTO_TEST_CASE(unserializeAsFixedShapeDeepMismatch) {
+
+	// At each level, the first key matches and the second does not:
+	// values decoded by the fast path must not be decoded again, or
+	// the time doubles with each level
+	const int depth = 40;
+
+	std::string data;
+
+	for (int i = 0 ; i < depth ; ++i) {
+		data += "a:2:{s:4:\"kids\";a:1:{i:0;";
+	}
+
+	data += "a:2:{s:4:\"kids\";a:0:{}s:2:\"id\";i:0;}";
+
+	for (int i = 0 ; i < depth ; ++i) {
+		data += "}s:2:\"ID\";i:1;}";
+	}
+
+	Node node = unserializeAs <Node>(data);
+
+	int levels = 0;
+
+	for (const Node *n = &node ; !n->kids.empty() ; n = &n->kids[0]) {
+		++levels;
+	}
+
+	BOOST_CHECK_EQUAL(depth, levels);
+}
@@ -21,6 +21,13 @@
 #include <boost/test/unit_test.hpp>
 
 #include "pherialize/unserialize.hpp"
+#include "pherialize/serialize.hpp"
+
+#include <sstream>
+#include <limits>
+#include <cmath>
+#include <cstring>
+#include <clocale>
 
 
 using namespace pherialize;
@@ -34,6 +41,15 @@ BOOST_AUTO_TEST_CASE(unserializeNull) {
 }
 
 
+BOOST_AUTO_TEST_CASE(unserializeNullValue) {
+
+	shared_ptr <Mixed> m = unserialize("N;");
+
+	BOOST_CHECK_EQUAL(Mixed::TYPE_NULL, m->type());
+	BOOST_CHECK(m->isNull());
+}
+
+
 BOOST_AUTO_TEST_CASE(unserializeString) {
 
 	shared_ptr <Mixed> m = unserialize("s:11:\"test string\";");
@@ -52,6 +68,36 @@ BOOST_AUTO_TEST_CASE(unserializeInteger) {
 }
 
 
+BOOST_AUTO_TEST_CASE(unserializeInteger64) {
+
+	BOOST_CHECK_EQUAL(1700000000123LL, unserialize("i:1700000000123;")->intValue());
+	BOOST_CHECK_EQUAL(-42, unserialize("i:-42;")->intValue());
+	BOOST_CHECK_EQUAL(INT64_MAX, unserialize("i:9223372036854775807;")->intValue());
+	BOOST_CHECK_EQUAL(INT64_MIN, unserialize("i:-9223372036854775808;")->intValue());
+
+	// Overflow
+	BOOST_CHECK_THROW(
+		unserialize("i:9223372036854775808;"),
+		std::runtime_error
+	);
+
+	BOOST_CHECK_THROW(
+		unserialize("i:-9223372036854775809;"),
+		std::runtime_error
+	);
+
+	BOOST_CHECK_THROW(
+		unserialize("s:99999999999999999999:\"a\";"),
+		std::runtime_error
+	);
+
+	// 64-bit keys
+	shared_ptr <Mixed> m = unserialize("a:1:{i:4294967296;s:1:\"a\";}");
+
+	BOOST_CHECK_EQUAL("a", m->arrayValue().find(static_cast <std::int64_t>(4294967296LL))->stringValue());
+}
+
+
 BOOST_AUTO_TEST_CASE(unserializeBool) {
 
 	shared_ptr <Mixed> m1 = unserialize("b:1;");
@@ -80,6 +126,77 @@ BOOST_AUTO_TEST_CASE(unserializeDouble) {
 }
 
 
+BOOST_AUTO_TEST_CASE(unserializeDoubleFormats) {
+
+	BOOST_CHECK_EQUAL(0.1, unserialize("d:0.1;")->doubleValue());
+	BOOST_CHECK_EQUAL(0.5, unserialize("d:.5;")->doubleValue());
+	BOOST_CHECK_EQUAL(2.0, unserialize("d:2.;")->doubleValue());
+	BOOST_CHECK_EQUAL(42.0, unserialize("d:42;")->doubleValue());
+	BOOST_CHECK_EQUAL(1.5, unserialize("d:+1.5;")->doubleValue());
+	BOOST_CHECK_EQUAL(1e25, unserialize("d:1.0E+25;")->doubleValue());
+	BOOST_CHECK_EQUAL(1e-5, unserialize("d:1.0E-5;")->doubleValue());
+	BOOST_CHECK_EQUAL(-1.5e300, unserialize("d:-1.5e300;")->doubleValue());
+	BOOST_CHECK_EQUAL(0.30000000000000004, unserialize("d:0.30000000000000004;")->doubleValue());
+	BOOST_CHECK_EQUAL(9007199254740993.0, unserialize("d:9007199254740993;")->doubleValue());
+	BOOST_CHECK_EQUAL(123456789012345678901234567890.0, unserialize("d:123456789012345678901234567890;")->doubleValue());
+	BOOST_CHECK_EQUAL(std::numeric_limits <double>::denorm_min(), unserialize("d:4.9E-324;")->doubleValue());
+	BOOST_CHECK_EQUAL(0.0, unserialize("d:0E+99999999;")->doubleValue());
+	BOOST_CHECK(std::signbit(unserialize("d:-0;")->doubleValue()));
+
+	BOOST_CHECK_EQUAL(std::numeric_limits <double>::infinity(), unserialize("d:INF;")->doubleValue());
+	BOOST_CHECK_EQUAL(-std::numeric_limits <double>::infinity(), unserialize("d:-INF;")->doubleValue());
+	BOOST_CHECK(std::isnan(unserialize("d:NAN;")->doubleValue()));
+
+	BOOST_CHECK_THROW(unserialize("d:;"), std::runtime_error);
+	BOOST_CHECK_THROW(unserialize("d:.;"), std::runtime_error);
+	BOOST_CHECK_THROW(unserialize("d:1e;"), std::runtime_error);
+	BOOST_CHECK_THROW(unserialize("d:1.5.5;"), std::runtime_error);
+	BOOST_CHECK_THROW(unserialize("d:-NAN;"), std::runtime_error);
+	BOOST_CHECK_THROW(unserialize("d:inf;"), std::runtime_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(unserializeDoubleRoundTrip) {
+
+	// Doubles written by the serializer (shortest representation)
+	// must be read back exactly
+	std::uint64_t state = 42;
+
+	for (int i = 0 ; i < 10000 ; ++i) {
+
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+
+		double value;
+		std::memcpy(&value, &state, sizeof(value));
+
+		if (std::isnan(value)) {
+			continue;
+		}
+
+		const std::string data = serialize(Mixed(value));
+		const double read = unserialize(data)->doubleValue();
+
+		BOOST_CHECK_MESSAGE(std::memcmp(&read, &value, sizeof(value)) == 0, data);
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(unserializeDoubleLocale) {
+
+	// Decimal point is always '.', whatever the locale
+	if (std::setlocale(LC_NUMERIC, "de_DE.UTF-8") == NULL &&
+	    std::setlocale(LC_NUMERIC, "fr_FR.UTF-8") == NULL) {
+		return;
+	}
+
+	const double value = unserialize("d:0.12345678901234567890123;")->doubleValue();
+
+	std::setlocale(LC_NUMERIC, "C");
+
+	BOOST_CHECK_EQUAL(0.12345678901234568, value);
+}
+
+
 const Mixed &readMap(const std::map <Mixed, Mixed> &map, const Mixed &key) {
 	const std::map <Mixed, Mixed>::const_iterator it = map.find(key);
 	if (it == map.end()) {
@@ -104,6 +221,33 @@ BOOST_AUTO_TEST_CASE(unserializeMap) {
 }
 
 
+BOOST_AUTO_TEST_CASE(unserializeVectorThenMap) {
+
+	// Consecutive integer keys followed by a non-consecutive key
+	shared_ptr <Mixed> m1 = unserialize("a:3:{i:0;s:1:\"a\";i:1;s:1:\"b\";s:1:\"k\";i:5;}");
+
+	BOOST_CHECK_EQUAL(Mixed::TYPE_ARRAY, m1->type());
+
+	const MixedArray &marr1 = m1->arrayValue();
+
+	BOOST_CHECK_EQUAL(MixedArray::TYPE_MAP, marr1.type());
+	BOOST_CHECK_EQUAL(3, marr1.mapValue().size());
+	BOOST_CHECK_EQUAL("a", readMap(marr1.mapValue(), 0).stringValue());
+	BOOST_CHECK_EQUAL("b", readMap(marr1.mapValue(), 1).stringValue());
+	BOOST_CHECK_EQUAL(5, readMap(marr1.mapValue(), "k").intValue());
+
+	// Integer keys not starting from 0
+	shared_ptr <Mixed> m2 = unserialize("a:2:{i:1;s:1:\"a\";i:2;s:1:\"b\";}");
+
+	const MixedArray &marr2 = m2->arrayValue();
+
+	BOOST_CHECK_EQUAL(MixedArray::TYPE_MAP, marr2.type());
+	BOOST_CHECK_EQUAL(2, marr2.mapValue().size());
+	BOOST_CHECK_EQUAL("a", readMap(marr2.mapValue(), 1).stringValue());
+	BOOST_CHECK_EQUAL("b", readMap(marr2.mapValue(), 2).stringValue());
+}
+
+
 BOOST_AUTO_TEST_CASE(unserializeVector) {
 
 	// Vector with 2 elements
@@ -148,6 +292,97 @@ BOOST_AUTO_TEST_CASE(unserializeVector) {
 }
 
 
+BOOST_AUTO_TEST_CASE(unserializeBuffer) {
+
+	// Buffer is not NUL-terminated and contains trailing garbage
+	// which must not be read
+	const char data[] = { 'i', ':', '4', '2', ';', '9', '9' };
+
+	shared_ptr <Mixed> m1 = unserialize(data, 5);
+
+	BOOST_CHECK_EQUAL(Mixed::TYPE_INT, m1->type());
+	BOOST_CHECK_EQUAL(42, m1->intValue());
+
+	// Truncated buffer
+	BOOST_CHECK_THROW(
+		unserialize(data, 3),
+		std::runtime_error
+	);
+
+	// Unserializer borrowing caller data
+	const std::string str = "s:2:\"ab\";";
+	Unserializer un(str.data(), str.length());
+
+	shared_ptr <Mixed> m2 = un.unserializeObject();
+
+	BOOST_CHECK_EQUAL(Mixed::TYPE_STRING, m2->type());
+	BOOST_CHECK_EQUAL("ab", m2->stringValue());
+	BOOST_CHECK(un.unserializeObject() == NULL);
+
+	// An embedded NUL character is not the end of data
+	const std::string trailingNul("i:1;\0junk", 9);
+	Unserializer un2(trailingNul);
+
+	BOOST_CHECK_EQUAL(1, un2.unserializeObject()->intValue());
+	BOOST_CHECK(!un2.atEnd());
+	BOOST_CHECK_THROW(unserialize(trailingNul), std::runtime_error);
+	BOOST_CHECK_THROW(unserialize(std::string("\0i:1;", 5)), std::runtime_error);
+	BOOST_CHECK_THROW(unserialize(std::string("a:1:{i:0;\0}", 11)), std::runtime_error);
+
+	// NUL characters inside strings are data
+	const std::string nulString("s:3:\"a\0b\";", 10);
+	BOOST_CHECK_EQUAL(std::string("a\0b", 3), unserialize(nulString)->stringValue());
+}
+
+
+BOOST_AUTO_TEST_CASE(unserializePathQuery) {
+
+	const std::string data =
+		"a:3:{"
+			"s:5:\"users\";a:2:{"
+				"i:0;a:1:{s:4:\"name\";s:5:\"alice\";}"
+				"i:1;a:2:{s:4:\"name\";s:3:\"bob\";s:5:\"prefs\";a:1:{s:4:\"lang\";s:2:\"fr\";}}"
+			"}"
+			"s:3:\"042\";i:1;"
+			"i:-5;O:8:\"stdClass\":1:{s:1:\"x\";d:0.5;}"
+		"}";
+
+	BOOST_CHECK(*unserializePath(data, {"users", "1", "prefs", "lang"}) == Mixed("fr"));
+	BOOST_CHECK(*unserializePath(data, {"users", "0", "name"}) == Mixed("alice"));
+	BOOST_CHECK(*unserializePath(data, {"042"}) == Mixed(1));
+	BOOST_CHECK(*unserializePath(data, {"-5", "x"}) == Mixed(0.5));
+	BOOST_CHECK(*unserializePath(data, {"users", "0"}) == *unserialize("a:1:{s:4:\"name\";s:5:\"alice\";}"));
+	BOOST_CHECK(*unserializePath(data, {}) == *unserialize(data));
+
+	// Missing values
+	BOOST_CHECK(unserializePath(data, {"users", "2"}) == NULL);
+	BOOST_CHECK(unserializePath(data, {"users", "01"}) == NULL);
+	BOOST_CHECK(unserializePath(data, {"42"}) == NULL);
+	BOOST_CHECK(unserializePath(data, {"users", "0", "name", "first"}) == NULL);
+	BOOST_CHECK(unserializePath("", {"a"}) == NULL);
+
+	// Data after the value is not read
+	BOOST_CHECK(*unserializePath("a:2:{s:1:\"a\";i:1;s:1:\"b\";x", {"a"}) == Mixed(1));
+
+	// Errors before the value are reported
+	BOOST_CHECK_THROW(
+		unserializePath("a:2:{s:1:\"b\";x:1;s:1:\"a\";i:1;}", {"a"}),
+		std::runtime_error
+	);
+
+	// Data truncated after a matched key is an error, not a missing value
+	BOOST_CHECK_THROW(
+		unserializePath("a:1:{s:1:\"a\";", {"a"}),
+		std::runtime_error
+	);
+
+	BOOST_CHECK_THROW(
+		unserializePath("a:1:{i:0;a:1:{i:3;", {"0", "3"}),
+		std::runtime_error
+	);
+}
+
+
 BOOST_AUTO_TEST_CASE(unserializeInvalid) {
 
 	// Incorrect string length
@@ -161,5 +396,108 @@ BOOST_AUTO_TEST_CASE(unserializeInvalid) {
 		unserialize("i:42:1234;"),
 		std::runtime_error
 	);
+
+	// Unterminated array
+	BOOST_CHECK_THROW(
+		unserialize("a:1:{i:0;"),
+		std::runtime_error
+	);
+
+	BOOST_CHECK_THROW(
+		unserialize("a:1:{i:0;i:1;"),
+		std::runtime_error
+	);
+}
+
+
+BOOST_AUTO_TEST_CASE(unserializeElementCount) {
+
+	shared_ptr <Mixed> m = unserialize("a:2:{i:0;s:1:\"a\";s:1:\"k\";i:1;}");
+
+	BOOST_CHECK_EQUAL(2, m->arrayValue().size());
+	BOOST_CHECK_EQUAL(0, MixedArray().size());
+
+	// Fewer elements than declared
+	BOOST_CHECK_THROW(
+		unserialize("a:2:{i:0;i:1;}"),
+		std::runtime_error
+	);
+
+	// More elements than declared
+	BOOST_CHECK_THROW(
+		unserialize("a:1:{i:0;i:1;i:1;i:2;}"),
+		std::runtime_error
+	);
+
+	// Count which cannot fit in the data
+	BOOST_CHECK_THROW(
+		unserialize("a:1000000000:{i:0;i:1;}"),
+		std::runtime_error
+	);
+
+	BOOST_CHECK_THROW(
+		unserialize("O:8:\"stdClass\":99999999:{}"),
+		std::runtime_error
+	);
+
+	// Same checks when reporting to a handler
+	UnserializeHandler handler;
+
+	BOOST_CHECK_THROW(
+		unserialize("a:2:{i:0;i:1;}", handler),
+		std::runtime_error
+	);
+
+	BOOST_CHECK_THROW(
+		unserialize("a:1000000000:{i:0;i:1;}", handler),
+		std::runtime_error
+	);
 }
 
+
+
+// Records events as a string
+class TraceHandler : public UnserializeHandler {
+
+public:
+
+	void onNull() { os << "N "; }
+	void onInt(const std::int64_t value) { os << "i" << value << " "; }
+	void onBool(const bool value) { os << "b" << value << " "; }
+	void onDouble(const double value) { os << "d" << value << " "; }
+	void onString(const char *str, const std::size_t length) { os << "s'" << std::string(str, length) << "' "; }
+	void onArrayBegin(const std::size_t count) { os << "[" << count << " "; }
+	void onObjectBegin(const char *className, const std::size_t classNameLength, const std::size_t count) {
+		os << "O'" << std::string(className, classNameLength) << "'" << count << " ";
+	}
+	void onKey() { os << "k "; }
+	void onArrayEnd() { os << "] "; }
+
+	std::ostringstream os;
+};
+
+
+BOOST_AUTO_TEST_CASE(unserializeHandler) {
+
+	TraceHandler h1;
+
+	BOOST_CHECK(unserialize("a:3:{i:0;s:2:\"ab\";s:1:\"k\";a:2:{i:0;b:1;i:1;N;}i:5;d:0.5;}", h1));
+	BOOST_CHECK_EQUAL("[3 k i0 s'ab' k s'k' [2 k i0 b1 k i1 N ] k i5 d0.5 ] ", h1.os.str());
+
+	TraceHandler h2;
+
+	BOOST_CHECK(unserialize("O:8:\"stdClass\":1:{s:1:\"a\";i:-1;}", h2));
+	BOOST_CHECK_EQUAL("O'stdClass'1 k s'a' i-1 ] ", h2.os.str());
+
+	// Empty data
+	TraceHandler h3;
+
+	BOOST_CHECK(!unserialize("", h3));
+	BOOST_CHECK_EQUAL("", h3.os.str());
+
+	// Trailing data is not reported
+	TraceHandler h4;
+
+	BOOST_CHECK_THROW(unserialize("i:1;i:2;", h4), std::runtime_error);
+	BOOST_CHECK_EQUAL("i1 ", h4.os.str());
+}
@@ -0,0 +1,165 @@
+//
+// PHP-compatible unserializer for C++
+//
+// Copyright (C) 2012-2013 Kisli    http://www.kisli.com
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//        http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+
+#define BOOST_TEST_MODULE pherialize_validate test
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "pherialize/validate.hpp"
+#include "pherialize/unserialize.hpp"
+
+#include <string>
+
+
+using namespace pherialize;
+
+
+static bool unserializes(const std::string &data) {
+
+	try {
+		unserialize(data);
+		return true;
+	} catch (std::runtime_error &) {
+		return false;
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(validateValid) {
+
+	BOOST_CHECK(validate("").valid);
+	BOOST_CHECK(validate("N;").valid);
+	BOOST_CHECK(validate("i:-9223372036854775808;").valid);
+	BOOST_CHECK(validate("i:0000000000000000000000042;").valid);
+	BOOST_CHECK(validate("b:1;").valid);
+	BOOST_CHECK(validate("d:1.0E+25;").valid);
+	BOOST_CHECK(validate("d:-INF;").valid);
+	BOOST_CHECK(validate("d:NAN;").valid);
+	BOOST_CHECK(validate("d:.5;").valid);
+	BOOST_CHECK(validate("s:6:\"a\";b\"c\";").valid);
+	BOOST_CHECK(validate("a:0:{}").valid);
+	BOOST_CHECK(validate("a:2:{i:0;s:1:\"a\";s:1:\"k\";a:1:{i:0;d:0.5;}}").valid);
+	BOOST_CHECK(validate("O:8:\"stdClass\":1:{s:1:\"x\";i:12345678901234;}").valid);
+
+	const ValidationResult res = validate("i:1;");
+
+	BOOST_CHECK(res.valid);
+	BOOST_CHECK(res.errorMessage == NULL);
+}
+
+
+BOOST_AUTO_TEST_CASE(validateErrorOffset) {
+
+	struct {
+		const char *data;
+		std::size_t offset;
+	} cases[] = {
+		{ "x:1;", 0 },                            // unknown type
+		{ "i:1", 3 },                             // missing ';'
+		{ "i:;", 2 },                             // no digits
+		{ "i:9223372036854775808;", 2 },          // overflow
+		{ "d:1.5e;", 6 },                         // missing exponent
+		{ "d:-NAN;", 3 },                         // signed NAN
+		{ "s:3:\"ab\";", 8 },                     // wrong string length
+		{ "s:30:\"ab\";", 5 },                    // string past end of data
+		{ "s:-1:\"\";", 2 },                      // negative length
+		{ "a:2:{i:0;i:1;}", 13 },                 // fewer elements than declared
+		{ "a:1:{i:0;i:1;i:1;i:2;}", 13 },         // more elements than declared
+		{ "a:1000:{i:0;i:1;}", 2 },               // count larger than data
+		{ "a:1:{i:0;a:1:{i:0;", 18 },             // truncated
+		{ "i:1;i:2;", 4 },                        // trailing data
+	};
+
+	for (std::size_t i = 0 ; i < sizeof(cases) / sizeof(cases[0]) ; ++i) {
+
+		const ValidationResult res = validate(cases[i].data);
+
+		BOOST_CHECK_MESSAGE(!res.valid, cases[i].data);
+		BOOST_CHECK_MESSAGE(res.errorMessage != NULL, cases[i].data);
+		BOOST_CHECK_MESSAGE(res.errorOffset == cases[i].offset,
+			cases[i].data << ": offset " << res.errorOffset << " != " << cases[i].offset);
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(validateDepth) {
+
+	std::string data;
+
+	for (int i = 0 ; i < 10 ; ++i) {
+		data += "a:1:{i:0;";
+	}
+
+	data += "N;";
+	data += std::string(10, '}');
+
+	BOOST_CHECK(validate(data, 10).valid);
+	BOOST_CHECK(!validate(data, 9).valid);
+	BOOST_CHECK_EQUAL(9 * 9, validate(data, 9).errorOffset);
+
+	// Deep nesting fails cleanly with the default limit
+	std::string deep;
+
+	for (int i = 0 ; i < 100000 ; ++i) {
+		deep += "a:1:{i:0;";
+	}
+
+	BOOST_CHECK(!validate(deep).valid);
+}
+
+
+BOOST_AUTO_TEST_CASE(validateMatchesUnserialize) {
+
+	const std::string data =
+		"a:4:{s:4:\"name\";s:6:\"foobar\";i:7;d:-1.25E-7;i:8;a:2:{i:0;b:0;i:1;N;}"
+		"s:1:\"o\";O:8:\"stdClass\":1:{s:1:\"x\";i:1234567890123456789;}}";
+
+	// Every prefix and every single-byte corruption is accepted by
+	// validate() exactly when it is accepted by unserialize()
+	for (std::size_t i = 0 ; i <= data.length() ; ++i) {
+
+		const std::string prefix = data.substr(0, i);
+		BOOST_CHECK_MESSAGE(validate(prefix).valid == unserializes(prefix), prefix);
+	}
+
+	const char replacements[] = { '0', '9', ':', ';', '{', '}', '"', 'a', 'x', '-', '.', 'E', '\0' };
+
+	for (std::size_t i = 0 ; i < data.length() ; ++i) {
+
+		for (std::size_t j = 0 ; j < sizeof(replacements) ; ++j) {
+
+			std::string corrupt = data;
+			corrupt[i] = replacements[j];
+
+			BOOST_CHECK_MESSAGE(validate(corrupt).valid == unserializes(corrupt), corrupt);
+		}
+	}
+
+	// Embedded NUL characters are data, not the end of data
+	const char *nulData[] = { "\0i:1;", "i:1;\0", "i:1\0;", "a:1:{i:0;\0}", "s:3:\"a\0b\";" };
+	const std::size_t nulLengths[] = { 5, 5, 5, 11, 10 };
+
+	for (std::size_t i = 0 ; i < sizeof(nulLengths) / sizeof(nulLengths[0]) ; ++i) {
+
+		const std::string str(nulData[i], nulLengths[i]);
+		BOOST_CHECK_MESSAGE(validate(str).valid == unserializes(str), i);
+	}
+
+	BOOST_CHECK_EQUAL(0, validate(std::string("\0i:1;", 5)).errorOffset);
+	BOOST_CHECK(validate(std::string("s:3:\"a\0b\";", 10)).valid);
+}